@@ -0,0 +1,98 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the table driven CRC8 against the original bitwise implementation on 65 byte frames.
+// Needs no camera attached.
+
+#include <Arduino.h>
+#include <Crc8.h>
+
+#define FRAME_SIZE 65
+#define ITERATIONS 10000
+
+uint8_t frame[FRAME_SIZE];
+
+uint8_t bitwiseCrc(const uint8_t *buf, size_t numBytes) {
+  uint8_t crc = 0;
+
+  for (size_t i = 0; i < numBytes; i++) {
+    crc ^= buf[i];
+
+    for (int j = 0; j < 8; ++j) {
+      if (crc & 0x80) {
+        crc = (crc << 1) ^ 0xd5;
+      } else {
+        crc = crc << 1;
+      }
+    }
+  }
+
+  return crc;
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam CRC8 Benchmark");
+
+  for (int i = 0; i < FRAME_SIZE; i++) {
+    frame[i] = random(256);
+  }
+
+  // The volatile sink stops the compiler from optimising the loops away
+  volatile uint8_t sink = 0;
+
+  unsigned long start = micros();
+  for (int i = 0; i < ITERATIONS; i++) {
+    frame[0] = i;
+    sink = sink ^ bitwiseCrc(frame, FRAME_SIZE);
+  }
+  unsigned long bitwiseTime = micros() - start;
+
+  start = micros();
+  for (int i = 0; i < ITERATIONS; i++) {
+    frame[0] = i;
+    sink = sink ^ RunCam::Crc8::calc(frame, FRAME_SIZE);
+  }
+  unsigned long tableTime = micros() - start;
+
+  bool match = true;
+  for (int i = 0; i < 256; i++) {
+    frame[0] = i;
+    if (bitwiseCrc(frame, FRAME_SIZE) != RunCam::Crc8::calc(frame, FRAME_SIZE)) {
+      match = false;
+    }
+  }
+
+  Serial.print("Results match: ");
+  Serial.println(match ? "Yes" : "No");
+
+  Serial.print("Bitwise: ");
+  Serial.print((float)bitwiseTime / ITERATIONS);
+  Serial.println(" us/frame");
+
+  Serial.print("Table: ");
+  Serial.print((float)tableTime / ITERATIONS);
+  Serial.println(" us/frame");
+
+  Serial.print("Speedup: ");
+  Serial.print((float)bitwiseTime / tableTime);
+  Serial.println("x");
+}
+
+void loop() {
+}
@@ -0,0 +1,267 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmarks CameraRuntime driving many cameras from one thread on Linux.  Each camera is a SimulatedCamera
+// on the far end of a pseudo-terminal, pumped by a second thread, so the runtime goes through the same tty
+// and epoll path as it would with real ports.  Every link keeps a read camera info request in flight for
+// the length of the test.
+//
+// Reports aggregate commands per second, latency percentiles across all links and how busy the runtime
+// thread was.  Build it on Linux with the host layer in src/host, see the readme.
+
+#include <Arduino.h>
+#include <RunCam_Protocol.h>
+#include <CameraRuntime.h>
+#include <SimulatedCamera.h>
+
+#ifdef RUNCAM_HAS_TERMIOS_TRANSPORT
+
+#include <atomic>
+#include <thread>
+#include <fcntl.h>
+#include <pty.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BAUD_RATE 115200
+#define TEST_MS 3000
+#define CAMERA_BOOT_MS 10
+#define PUMP_IDLE_US 100
+
+const uint8_t CAMERA_COUNTS[] = { 1, 8, 32, 64 };
+
+struct Camera {
+  int master;
+  RunCam::SimulatedCamera *simulated;
+  RunCam::TermiosTransport *port;
+  RunCam::Protocol *protocol;
+  volatile bool *running;
+  uint32_t completed;
+  uint32_t failed;
+};
+
+Camera cameras[CAMERA_RUNTIME_MAX_LINKS];
+
+void readCameraInfoDone(const RunCam::CommandResult &result, void *context) {
+  Camera *camera = (Camera *)context;
+  if (result.success) {
+    camera->completed++;
+  } else {
+    camera->failed++;
+  }
+
+  if (*camera->running) {
+    camera->protocol->submitReadCameraInfo(readCameraInfoDone, camera);
+  }
+}
+
+// The camera ends of the ptys.  Moves requests into each simulated camera and its responses back out.
+void pumpCameras(uint8_t count, std::atomic<bool> *stop) {
+  uint8_t buf[256];
+
+  while (!stop->load()) {
+    bool moved = false;
+
+    for (uint8_t i = 0; i < count; i++) {
+      Camera *camera = &cameras[i];
+
+      ssize_t length = read(camera->master, buf, sizeof(buf));
+      if (length > 0) {
+        camera->simulated->write(buf, length);
+        moved = true;
+      }
+
+      length = 0;
+      while (camera->simulated->available() && length < (ssize_t)sizeof(buf)) {
+        buf[length++] = camera->simulated->read();
+      }
+      if (length > 0) {
+        write(camera->master, buf, length);
+        moved = true;
+      }
+    }
+
+    if (!moved) {
+      struct timespec idle = { 0, PUMP_IDLE_US * 1000L };
+      nanosleep(&idle, NULL);
+    }
+  }
+}
+
+unsigned long getThreadCpuTime() {
+  struct timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+void runBenchmark(uint8_t count) {
+  RunCam::CameraRuntime runtime;
+  runtime.begin();
+
+  volatile bool running = true;
+
+  for (uint8_t i = 0; i < count; i++) {
+    Camera *camera = &cameras[i];
+    int slave;
+    if (openpty(&camera->master, &slave, NULL, NULL, NULL) != 0) {
+      Serial.println("openpty failed");
+      return;
+    }
+    fcntl(camera->master, F_SETFL, fcntl(camera->master, F_GETFL) | O_NONBLOCK);
+
+    camera->simulated = new RunCam::SimulatedCamera(BAUD_RATE, CAMERA_BOOT_MS);
+    camera->simulated->begin(BAUD_RATE);
+    camera->simulated->powerOn();
+    camera->port = new RunCam::TermiosTransport(slave);
+    camera->protocol = new RunCam::Protocol(camera->port, BAUD_RATE);
+    camera->running = &running;
+    camera->completed = 0;
+    camera->failed = 0;
+
+    runtime.addLink(camera->protocol, camera->port);
+  }
+
+  std::atomic<bool> stop(false);
+  std::thread pump(pumpCameras, count, &stop);
+
+  // Wait for every camera to answer its startup probe
+  bool ready = false;
+  while (!ready) {
+    runtime.runOnce(CAMERA_RUNTIME_RUN_WAIT_MS);
+    ready = true;
+    for (uint8_t i = 0; i < count; i++) {
+      ready = ready && cameras[i].protocol->isReady();
+    }
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    cameras[i].protocol->clearStats();
+    cameras[i].protocol->submitReadCameraInfo(readCameraInfoDone, &cameras[i]);
+  }
+  runtime.clearStats();
+
+  unsigned long startTime = millis();
+  unsigned long startCpu = getThreadCpuTime();
+  while (millis() - startTime < TEST_MS) {
+    runtime.runOnce(TEST_MS);
+  }
+  running = false;
+  unsigned long cpuTime = getThreadCpuTime() - startCpu;
+  unsigned long elapsed = millis() - startTime;
+
+  // Let the last requests finish so nothing is left pointing at the cameras
+  for (uint8_t i = 0; i < count; i++) {
+    while (cameras[i].protocol->getQueuedCommandCount() > 0) {
+      runtime.runOnce(CAMERA_RUNTIME_RUN_WAIT_MS);
+    }
+  }
+
+  stop = true;
+  pump.join();
+
+  // Merge every link's read camera info latencies
+  RunCam::CommandStats total;
+  memset(&total, 0, sizeof(total));
+  total.minLatency = 0xffffffff;
+
+  uint32_t completed = 0;
+  uint32_t failed = 0;
+  for (uint8_t i = 0; i < count; i++) {
+    const RunCam::ProtocolStats *stats = cameras[i].protocol->getStats();
+    const RunCam::CommandStats *command = &stats->commands[RunCam::Protocol::getResponseCommandIndex(COMMAND_READ_CAMERA_INFO)];
+
+    total.responses += command->responses;
+    total.timeouts += command->timeouts;
+    total.totalLatency += command->totalLatency;
+    if (command->minLatency < total.minLatency) {
+      total.minLatency = command->minLatency;
+    }
+    if (command->maxLatency > total.maxLatency) {
+      total.maxLatency = command->maxLatency;
+    }
+    for (uint8_t bucket = 0; bucket < PROTOCOL_STATS_BUCKETS; bucket++) {
+      uint32_t sum = total.histogram[bucket] + command->histogram[bucket];
+      total.histogram[bucket] = sum < 0xffff ? sum : 0xffff;
+    }
+
+    completed += cameras[i].completed;
+    failed += cameras[i].failed;
+  }
+
+  const RunCam::CameraRuntimeStats *runtimeStats = runtime.getStats();
+
+  Serial.print(count);
+  Serial.print(" cameras: ");
+  Serial.print(completed * 1000UL / elapsed);
+  Serial.print(" commands/s, ");
+  Serial.print(completed * 1000UL / elapsed / count);
+  Serial.print(" per camera, ");
+  Serial.print(failed);
+  Serial.println(" failed");
+
+  Serial.print("  Latency: avg ");
+  Serial.print(total.responses > 0 ? total.totalLatency / total.responses : 0);
+  Serial.print("us min ");
+  Serial.print(total.minLatency);
+  Serial.print("us p50 < ");
+  Serial.print(RunCam::getLatencyPercentile(&total, 50));
+  Serial.print("us p99 < ");
+  Serial.print(RunCam::getLatencyPercentile(&total, 99));
+  Serial.print("us max ");
+  Serial.print(total.maxLatency);
+  Serial.println("us");
+
+  Serial.print("  Runtime thread: ");
+  Serial.print(cpuTime * 100 / (elapsed * 1000UL));
+  Serial.print("% cpu, ");
+  Serial.print(runtimeStats->wakeups * 1000UL / elapsed);
+  Serial.print(" wakeups/s, ");
+  Serial.print(runtimeStats->wakeups > 0 ? (float)runtimeStats->polls / runtimeStats->wakeups : 0);
+  Serial.println(" links polled per wakeup");
+
+  for (uint8_t i = 0; i < count; i++) {
+    delete cameras[i].protocol;
+    delete cameras[i].port;
+    delete cameras[i].simulated;
+    close(cameras[i].master);
+  }
+}
+
+void setup() {
+  Serial.begin(1000000);
+
+  Serial.println("RunCam Multi Camera Benchmark");
+
+  for (uint8_t i = 0; i < sizeof(CAMERA_COUNTS); i++) {
+    if (CAMERA_COUNTS[i] <= CAMERA_RUNTIME_MAX_LINKS) {
+      runBenchmark(CAMERA_COUNTS[i]);
+    }
+  }
+}
+
+#else
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("The multi camera runtime needs Linux");
+}
+
+#endif
+
+void loop() {
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Draws a simple HUD on the camera OSD.  Only the characters that change each frame are sent, and the
+// scheduler keeps the link within its bandwidth with the fast changing values sent first.
+
+#include <Arduino.h>
+#include <RunCam_Split4.h>
+#include <OsdFrameBuffer.h>
+#include <OsdScheduler.h>
+
+RunCam::Split4* device;
+RunCam::OsdFrameBuffer* osd;
+RunCam::OsdScheduler* scheduler;
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam OSD HUD");
+
+  device = new RunCam::Split4(&Serial1);
+
+  int columns = device->getDisplayColumns();
+  if (columns <= 0) {
+    columns = 30;
+  }
+
+  osd = new RunCam::OsdFrameBuffer(columns, device->getDisplayRows());
+
+  osd->print(1, 1, "ALT");
+  osd->print(1, 2, "BAT");
+  osd->print(columns - 6, 1, "SD");
+  osd->print(columns - 3, 1, device->hasSdCard() ? "OK" : "--");
+
+  scheduler = new RunCam::OsdScheduler(osd, device->getProtocol());
+
+  // Altitude and battery every 50ms, labels and SD status once a second
+  scheduler->addElement(5, 1, 6, 1, OSD_PRIORITY_HIGH, 50);
+  scheduler->addElement(5, 2, 6, 1, OSD_PRIORITY_HIGH, 50);
+  scheduler->addElement(0, 0, 5, 3, OSD_PRIORITY_LOW, 1000);
+  scheduler->addElement(columns - 6, 1, 6, 1, OSD_PRIORITY_LOW, 1000);
+}
+
+void loop() {
+  unsigned long now = millis();
+
+  osd->print(5, 1, String((now / 100) % 1000) + "m  ");
+  osd->print(5, 2, String(1680 - (now / 1000) % 400) + "  ");
+
+  size_t bytesSent = scheduler->tick();
+
+  if (bytesSent > 0) {
+    Serial.print("Sent ");
+    Serial.print(bytesSent);
+    Serial.println(" bytes");
+  }
+}
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Reports how many bytes the OSD planner sends for some representative HUD layouts compared with
+// sending every changed cell with write char and with redrawing every row.  Needs no camera attached.
+
+#include <Arduino.h>
+#include <OsdFrameBuffer.h>
+
+#define COLUMNS 30
+#define ROWS OSD_ROWS_PAL
+
+RunCam::OsdFrameBuffer osd(COLUMNS, ROWS);
+
+// Bytes to send every changed cell with its own write char command
+size_t perCellCost() {
+  size_t count = 0;
+
+  for (uint8_t y = 0; y < ROWS; y++) {
+    for (uint8_t x = 0; x < COLUMNS; x++) {
+      if (osd.isDirty(x, y)) {
+        count++;
+      }
+    }
+  }
+
+  return count * OSD_COST_WRITE_CHAR;
+}
+
+// Bytes to redraw the whole screen one row at a time
+size_t fullRedrawCost() {
+  return ROWS * (OSD_COST_STRING_BASE + COLUMNS);
+}
+
+void report(const char *name) {
+  size_t planned = osd.getCommitCost();
+  size_t perCell = perCellCost();
+  RunCam::OsdPlanStats stats = osd.getPlanStats();
+
+  Serial.print(name);
+  Serial.print(": planned ");
+  Serial.print(planned);
+  Serial.print(" bytes, per cell ");
+  Serial.print(perCell);
+  Serial.print(" bytes, full redraw ");
+  Serial.print(fullRedrawCost());
+  Serial.print(" bytes (");
+  Serial.print(stats.fills);
+  Serial.print(" fill, ");
+  Serial.print(stats.horizontalStrings);
+  Serial.print(" horizontal, ");
+  Serial.print(stats.verticalStrings);
+  Serial.print(" vertical, ");
+  Serial.print(stats.charAtPosBatches);
+  Serial.print(" batch, ");
+  Serial.print(stats.chars);
+  Serial.println(" char)");
+
+  // Pretend the frame was sent so the next layout is diffed against it
+  osd.commit(NULL);
+}
+
+void drawStatic() {
+  osd.print(1, 1, "ALT");
+  osd.print(1, 2, "SPD");
+  osd.print(1, 3, "BAT");
+  osd.print(COLUMNS - 7, 1, "SD");
+  osd.print(COLUMNS - 7, 2, "REC");
+  osd.fill(0, ROWS - 1, COLUMNS, 1, '-');
+  osd.printVertical(COLUMNS / 2, 5, "|||||");
+}
+
+void drawTelemetry(int frame) {
+  osd.print(5, 1, String(120 + frame % 7) + "m ");
+  osd.print(5, 2, String(42 + frame % 3) + "kmh ");
+  osd.print(5, 3, String(16.8 - frame * 0.01) + "v");
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam OSD Planner Benchmark");
+
+  // The planner only works out the cost so no camera is needed, but commit() still expects the screen
+  // to have been cleared once
+  osd.commit(NULL);
+
+  drawStatic();
+  report("Static labels");
+
+  drawTelemetry(1);
+  report("Telemetry update");
+
+  drawTelemetry(2);
+  report("Telemetry update");
+
+  osd.fill(8, 6, 14, 4, '#');
+  report("Warning box");
+
+  for (int i = 0; i < 12; i++) {
+    osd.setChar((i * 7) % COLUMNS, 4 + (i * 5) % 8, '*');
+  }
+  report("Scattered markers");
+
+  osd.clear();
+  report("Clear");
+}
+
+void loop() {
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks that the OSD scheduler keeps to a low budget when ticked every millisecond, where each tick earns
+// less than a byte.  Runs against a simulated Split 4, on the board or on a host, and prints PASS or FAIL
+// for each check.
+
+#include <Arduino.h>
+#include <RunCam_Protocol.h>
+#include <SimulatedCamera.h>
+#include <OsdFrameBuffer.h>
+#include <OsdScheduler.h>
+
+#define TEST_BUDGET 200                 // Bytes per second, a fifth of a byte per millisecond
+#define TEST_DURATION_MS 2000
+
+RunCam::SimulatedCamera camera;
+uint8_t failures = 0;
+
+void check(const char *name, bool passed) {
+  Serial.print(passed ? "PASS " : "FAIL ");
+  Serial.println(name);
+  if (!passed) {
+    failures++;
+  }
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam OSD Scheduler Test");
+
+  camera.powerOn();
+
+  RunCam::Protocol protocol(&camera);
+  protocol.waitUntilReady();
+
+  RunCam::OsdFrameBuffer osd(30, 16);
+  RunCam::OsdScheduler scheduler(&osd, &protocol, TEST_BUDGET);
+  scheduler.addElement(0, 0, 1, 1, OSD_PRIORITY_NORMAL, 0);
+
+  // Use up the saved budget first
+  do {
+    osd.setChar(0, 0, osd.getChar(0, 0) == 'A' ? 'B' : 'A');
+  } while (scheduler.tick() > 0);
+
+  // Change the element on every tick so everything earned is spent
+  size_t before = scheduler.getBytesSent();
+  unsigned long start = millis();
+  unsigned long last = start;
+
+  while (millis() - start < TEST_DURATION_MS) {
+    while (millis() == last);
+    last = millis();
+
+    if (!osd.isDirty()) {
+      osd.setChar(0, 0, osd.getChar(0, 0) == 'A' ? 'B' : 'A');
+    }
+    scheduler.tick();
+  }
+
+  size_t sent = scheduler.getBytesSent() - before;
+  size_t expected = (size_t)TEST_BUDGET * (millis() - start) / 1000;
+
+  Serial.print("  sent ");
+  Serial.print(sent);
+  Serial.print(" bytes, budget ");
+  Serial.print(expected);
+  Serial.println(" bytes");
+
+  check("tokens accrue from ticks worth less than a byte", sent >= expected * 3 / 4);
+  check("budget is kept", sent <= expected + COMMAND_BUFF_SIZE);
+
+  Serial.println(failures == 0 ? "All checks passed" : "Checks failed");
+}
+
+void loop() {
+}
@@ -21,6 +21,73 @@
 #include <RunCam_Protocol.h>
 
 RunCam::Protocol* protocol;
+RunCam::SettingsStore settings;
+
+// Prints each kind of setting detail
+class DetailPrinter : public RunCam::SettingValueVisitor {
+  public:
+    void visit(uint8_t settingId, const RunCam::UInt8Value &value) {
+      printRange(value.value, value.min, value.max, value.stepSize);
+    }
+
+    void visit(uint8_t settingId, const RunCam::Int8Value &value) {
+      printRange(value.value, value.min, value.max, value.stepSize);
+    }
+
+    void visit(uint8_t settingId, const RunCam::UInt16Value &value) {
+      printRange(value.value, value.min, value.max, value.stepSize);
+    }
+
+    void visit(uint8_t settingId, const RunCam::Int16Value &value) {
+      printRange(value.value, value.min, value.max, value.stepSize);
+    }
+
+    void visit(uint8_t settingId, const RunCam::FloatValue &value) {
+      printRange(value.value, value.min, value.max, value.stepSize);
+      Serial.print(", Decimal Point: ");
+      Serial.print(value.decimalPoint);
+    }
+
+    void visit(uint8_t settingId, const RunCam::TextSelectionValue &value, const char *options) {
+      Serial.print("Value: ");
+      Serial.print(value.value);
+      Serial.print(", Text Selection: (");
+      Serial.print(value.optionCount);
+      Serial.print(") ");
+
+      for (int i = 0; i < value.optionCount; i++) {
+        if (i > 0) {
+          Serial.print(", ");
+        }
+        Serial.print(options);
+        options += strlen(options) + 1;
+      }
+    }
+
+    void visit(uint8_t settingId, const RunCam::StringValue &value, const char *text) {
+      Serial.print("Value: ");
+      Serial.print(text);
+      Serial.print(", Max String Size: ");
+      Serial.print(value.maxStringSize);
+    }
+
+    void visit(uint8_t settingId, const RunCam::InfoValue &value, const char *text) {
+      Serial.print("Value: ");
+      Serial.print(text);
+    }
+
+  private:
+    void printRange(long value, long min, long max, long stepSize) {
+      Serial.print("Value: ");
+      Serial.print(value);
+      Serial.print(", Min: ");
+      Serial.print(min);
+      Serial.print(", Max: ");
+      Serial.print(max);
+      Serial.print(", Step Size: ");
+      Serial.print(stepSize);
+    }
+};
 
 void setup() {
   Serial.begin(1000000);
@@ -28,7 +95,20 @@ void setup() {
 
   Serial.println("RunCam Control");
 
-  protocol = new RunCam::Protocol(&Serial1);
+  // Pass AUTO_BAUD_RATE instead to find the rate the camera is using
+  protocol = new RunCam::Protocol(&Serial1, DEFAULT_BAUD_RATE);
+
+  protocol->waitUntilReady();
+
+  Serial.print("Baud Rate: ");
+  Serial.print(protocol->getBaudRate());
+  Serial.println(protocol->isBaudRateDetected() ? " (detected)" : "");
+  Serial.print("Throughput: ");
+  Serial.print(protocol->getThroughput());
+  Serial.println(" bytes/s");
+  Serial.print("Startup Time: ");
+  Serial.print(protocol->getStartupTime());
+  Serial.println("ms");
 
   uint8_t version;
   uint16_t features;
@@ -65,179 +145,58 @@ void setup() {
   }
 
 
-  auto settings = std::vector<RunCam::Setting*>();
-
   int remainingChunks;
-  int i;
+  int i = 0;
   do {
     remainingChunks = protocol->getSetting(i++, &settings);
   } while (remainingChunks > 0);
 
   Serial.println("Settings:");
   Serial.print("  Count: ");
-  Serial.println(settings.size());
+  Serial.println(settings.getCount());
   
-  for(int i=0; i < settings.size(); i++){
+  for(int i=0; i < settings.getCount(); i++){
+    RunCam::SettingRecord *setting = settings.get(i);
+
     Serial.print("  ");
-    Serial.print(settings[i]->getId());
+    Serial.print(setting->id);
     Serial.print(": ");
-    Serial.print(settings[i]->getName());
+    Serial.print(settings.getName(setting));
     Serial.print(" = ");
-    Serial.print(settings[i]->getValue());
+    Serial.print(settings.getValue(setting));
     Serial.println("");
   }
 
-  auto settingDetails = std::vector<RunCam::SettingDetail*>();
-
   for (int i = 0; i < 7; i++) {
     remainingChunks = 0;
     do {
-      remainingChunks = protocol->readSettingDetail(i, 0, &settingDetails);
+      remainingChunks = protocol->readSettingDetail(i, 0, &settings);
     } while (remainingChunks > 0);
   }
 
   Serial.println("Setting Details:");
-  Serial.print("  Count: ");
-  Serial.println(settingDetails.size());
 
-  for(int i=0; i < settingDetails.size(); i++){
+  DetailPrinter printer;
+  for(int i=0; i < settings.getCount(); i++){
+    RunCam::SettingRecord *setting = settings.get(i);
+    if (setting->detail.isEmpty()) {
+      continue;
+    }
+
     Serial.print("  Setting Id: ");
-    Serial.print(settingDetails[i]->getSettingId());
+    Serial.print(setting->id);
     Serial.print(", Type: ");
-    Serial.print(settingDetails[i]->getSettingType());
+    Serial.print(setting->detail.getType());
     Serial.print(", ");
 
-    switch (settingDetails[i]->getSettingType()) {
-      case SETTING_TYPE_UINT8: {
-        RunCam::UInt8SettingDetail* setting = (RunCam::UInt8SettingDetail*)settingDetails[i];
-
-        Serial.print("Value: ");
-        Serial.print(setting->getValue());
-        Serial.print(", Min: ");
-        Serial.print(setting->getMin());
-        Serial.print(", Max: ");
-        Serial.print(setting->getMax());
-        Serial.print(", Step Size: ");
-        Serial.print(setting->getStepSize());
-
-        break;
-      }
-
-      case SETTING_TYPE_INT8: {
-        RunCam::Int8SettingDetail* setting = (RunCam::Int8SettingDetail*)settingDetails[i];
-
-        Serial.print("Value: ");
-        Serial.print(setting->getValue());
-        Serial.print(", Min: ");
-        Serial.print(setting->getMin());
-        Serial.print(", Max: ");
-        Serial.print(setting->getMax());
-        Serial.print(", Step Size: ");
-        Serial.print(setting->getStepSize());
-
-        break;
-      }
-
-      case SETTING_TYPE_UINT16: {
-        RunCam::UInt16SettingDetail* setting = (RunCam::UInt16SettingDetail*)settingDetails[i];
-
-        Serial.print("Value: ");
-        Serial.print(setting->getValue());
-        Serial.print(", Min: ");
-        Serial.print(setting->getMin());
-        Serial.print(", Max: ");
-        Serial.print(setting->getMax());
-        Serial.print(", Step Size: ");
-        Serial.print(setting->getStepSize());
-
-        break;
-      }
-
-      case SETTING_TYPE_INT16: {
-        RunCam::Int16SettingDetail* setting = (RunCam::Int16SettingDetail*)settingDetails[i];
-
-        Serial.print("Value: ");
-        Serial.print(setting->getValue());
-        Serial.print(", Min: ");
-        Serial.print(setting->getMin());
-        Serial.print(", Max: ");
-        Serial.print(setting->getMax());
-        Serial.print(", Step Size: ");
-        Serial.print(setting->getStepSize());
-
-        break;
-      }
-
-      case SETTING_TYPE_FLOAT: {
-        RunCam::FloatSettingDetail* setting = (RunCam::FloatSettingDetail*)settingDetails[i];
-
-        Serial.print("Value: ");
-        Serial.print(setting->getValue());
-        Serial.print(", Min: ");
-        Serial.print(setting->getMin());
-        Serial.print(", Max: ");
-        Serial.print(setting->getMax());
-        Serial.print(", Decimal Point: ");
-        Serial.print(setting->getDecimalPoint());
-        Serial.print(", Step Size: ");
-        Serial.print(setting->getStepSize());
-
-        break;
-      }
-
-      case SETTING_TYPE_TEXT_SELECTION: {
-        RunCam::TextSelectionSettingDetail* setting = (RunCam::TextSelectionSettingDetail*)settingDetails[i];
-
-        Serial.print("Value: ");
-        Serial.print(setting->getValue());
-        Serial.print(", Text Selection: (");
-        
-        std::vector<String*>* value = setting->getTextSelection();
-        Serial.print(value->size());
-        Serial.print(") ");
-
-        for (int i = 0; i < value->size(); i++) {
-          if (i > 0) {
-            Serial.print(", ");
-          }
-          Serial.print(*value->at(i));
-        }
-
-        break;
-      }
-
-      case SETTING_TYPE_STRING: {
-        RunCam::StringSettingDetail* setting = (RunCam::StringSettingDetail*)settingDetails[i];
-
-        Serial.print("Value: ");
-        Serial.print(setting->getValue());
-        Serial.print(", Max String Size: ");
-        Serial.print(setting->getMaxStringSize());
-
-        break;
-      }
-
-      case SETTING_TYPE_FOLDER: {
-        break;
-      }
-
-      case SETTING_TYPE_INFO: {
-        RunCam::InfoSettingDetail* setting = (RunCam::InfoSettingDetail*)settingDetails[i];
-
-        Serial.print("Value: ");
-        Serial.print(setting->getValue());
-
-        break;
-      }
-
-      default: {
-        Serial.println(" - Unknown");
-        break;
-      }
-    }
+    settings.visit(setting, &printer);
 
     Serial.println("");
   }
+
+  Serial.print("Settings Memory: ");
+  Serial.print(settings.getPeakMemoryUsage());
+  Serial.println(" bytes");
 }
 
 void loop() {
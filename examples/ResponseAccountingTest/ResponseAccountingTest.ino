@@ -0,0 +1,137 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks that a response is accounted to the request it answers when commands without a response are sent
+// while it is pending, and that a camera that doesn't answer is given up on quickly before any round trips
+// have been measured.  Runs against a simulated Split 4, on the board or on a host, and prints PASS or
+// FAIL for each check.
+
+#include <Arduino.h>
+#include <RunCam_Protocol.h>
+#include <SimulatedCamera.h>
+
+RunCam::SimulatedCamera camera;
+RunCam::SettingsStore store;
+uint8_t failures = 0;
+bool settingsDone = false;
+
+void check(const char *name, bool passed) {
+  Serial.print(passed ? "PASS " : "FAIL ");
+  Serial.println(name);
+  if (!passed) {
+    failures++;
+  }
+}
+
+void settingsRead(const RunCam::CommandResult &result, void *context) {
+  settingsDone = result.success;
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam Response Accounting Test");
+
+  camera.powerOn();
+
+  RunCam::Protocol protocol(&camera);
+  protocol.waitUntilReady();
+
+  RunCam::RttEstimator *settingsRtt = protocol.getRttEstimator(COMMAND_GET_SETTINGS);
+  settingsRtt->reset();
+#ifndef RUNCAM_NO_STATS
+  protocol.clearStats();
+#endif
+
+  // Send the settings request, then write to the display while its response is on the way
+  protocol.submitGetSetting(0, &store, settingsRead);
+  protocol.poll();
+  check("settings response pending", protocol.isResponsePending());
+
+  protocol.displayWriteChar(1, 1, 'A');
+  protocol.displayWriteHorizontalString(2, 2, "OSD");
+  protocol.flush();
+
+  check("settings read", settingsDone);
+  check("one RTT sample for the settings request", settingsRtt->getSampleCount() == 1);
+
+  // The camera answers no sooner than its turnaround time after the settings request.  Nothing bounds how
+  // much later on a busy machine, so only the lower bound is checked.
+  unsigned long rtt = settingsRtt->getSmoothedRtt();
+  Serial.print("  settings RTT sample ");
+  Serial.print(rtt);
+  Serial.println("us");
+  check("RTT sample is at least the camera's turnaround", rtt >= SIMULATED_CAMERA_DEFAULT_TURNAROUND_US / 2);
+
+#ifndef RUNCAM_NO_STATS
+  // The response counts, with its latency, for the settings request and not the last command written
+  const RunCam::ProtocolStats *stats = protocol.getStats();
+  const RunCam::CommandStats *settingsStats = RunCam::getCommandStats((RunCam::ProtocolStats *)stats, COMMAND_GET_SETTINGS);
+  uint32_t responses = 0;
+  for (uint8_t i = 0; i < PROTOCOL_STATS_COMMANDS; i++) {
+    responses += stats->commands[i].responses;
+  }
+
+  check("three requests sent", stats->requests == 3);
+  check("one response counted", responses == 1);
+  check("response counted for the settings request", settingsStats->requests == 1 && settingsStats->responses == 1);
+  check("settings latency is at least the camera's turnaround", settingsStats->minLatency >= SIMULATED_CAMERA_DEFAULT_TURNAROUND_US / 2);
+  check("settings latency is ordered", settingsStats->minLatency <= settingsStats->totalLatency / settingsStats->responses &&
+      settingsStats->totalLatency / settingsStats->responses <= settingsStats->maxLatency);
+  check("RTT sample is within the measured latency", rtt <= settingsStats->maxLatency);
+
+  // Let a settings request time out, write to the display and ask again.  The display write in between
+  // doesn't stop the second request counting as a retry.
+  camera.setTurnaroundTime(100000);
+  settingsDone = false;
+  protocol.submitGetSetting(0, &store, settingsRead);
+  protocol.flush();
+  check("slow settings request failed", !settingsDone && settingsStats->timeouts == 1);
+
+  delay(150);
+  camera.setTurnaroundTime(SIMULATED_CAMERA_DEFAULT_TURNAROUND_US);
+  protocol.displayWriteChar(1, 1, 'B');
+  protocol.submitGetSetting(0, &store, settingsRead);
+  protocol.flush();
+  check("settings read again", settingsDone);
+  check("retry counted across the display write", stats->retries == 1 && settingsStats->retries == 1);
+  check("no retry counted for the display write", stats->requests == 6);
+#endif
+
+  // A command with no round trips measured yet, as after a baud rate change resets them, gives up on a
+  // camera that doesn't answer after the initial timeout rather than the ceiling
+  settingsRtt->reset();
+  check("cold settings timeout is the initial one", settingsRtt->getTimeout() == RTT_TIMEOUT_INITIAL_US);
+
+  camera.powerOn();
+  settingsDone = false;
+  unsigned long start = millis();
+  protocol.submitGetSetting(0, &store, settingsRead);
+  protocol.flush();
+  unsigned long elapsed = millis() - start;
+  Serial.print("  cold settings request gave up after ");
+  Serial.print(elapsed);
+  Serial.println("ms");
+  check("cold settings request failed", !settingsDone);
+  check("cold settings request gave up before the ceiling", elapsed < RTT_TIMEOUT_CEILING_US / 1000);
+  check("cold settings timeout backed off", settingsRtt->getTimeout() == RTT_TIMEOUT_INITIAL_US * 2);
+
+  Serial.println(failures == 0 ? "All checks passed" : "Checks failed");
+}
+
+void loop() {
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks that a chunked response claiming more payload than its command can carry is dropped at that
+// bound and parsing resyncs on the real response behind it.  Runs on the board or on a host, first
+// against the parser alone and then through Protocol and a simulated Split 4, and prints PASS or FAIL for
+// each check.
+
+#include <Arduino.h>
+#include <RunCam_Protocol.h>
+#include <SimulatedCamera.h>
+#include <ResponseParser.h>
+#include <Crc8.h>
+
+// Responses start with the same header byte as requests.  This is a stray one whose length byte is one
+// more than a setting chunk can hold, but would still fit in a frame.
+const uint8_t TOO_LONG[] = { COMMAND_HEADER, 0x00, SETTINGS_CHUNK_MAX_DATA + 1 };
+
+RunCam::SimulatedCamera camera;
+uint8_t failures = 0;
+
+void check(const char *name, bool passed) {
+  Serial.print(passed ? "PASS " : "FAIL ");
+  Serial.println(name);
+  if (!passed) {
+    failures++;
+  }
+}
+
+// A chunked frame with dataLength bytes of payload.  Returns its length.
+size_t makeChunk(uint8_t *frame, uint8_t dataLength) {
+  frame[0] = COMMAND_HEADER;
+  frame[1] = 0;
+  frame[2] = dataLength;
+  for (uint8_t i = 0; i < dataLength; i++) {
+    frame[3 + i] = 'A' + i % 26;
+  }
+  frame[3 + dataLength] = RunCam::Crc8::calc(frame, 3 + dataLength);
+
+  return dataLength + 4;
+}
+
+uint8_t feed(RunCam::ResponseParser *parser, const uint8_t *data, size_t length) {
+  uint8_t state = parser->getState();
+  for (size_t i = 0; i < length; i++) {
+    state = parser->feed(data[i]);
+  }
+
+  return state;
+}
+
+void checkParser() {
+  RunCam::ResponseParser parser;
+  uint8_t frame[RESPONSE_BUFF_SIZE];
+  size_t length = makeChunk(frame, 2);
+
+  // Dropped as soon as the length byte arrives, then the real chunk is found
+  parser.expectChunked(SETTINGS_CHUNK_MAX_DATA);
+  feed(&parser, TOO_LONG, sizeof(TOO_LONG));
+  check("too long length byte isn't waited on", parser.getState() == RESPONSE_PARSER_PENDING && parser.getLength() == 0);
+  check("resynced at the bound", parser.getResyncCount() == 1 && parser.getSkippedCount() == sizeof(TOO_LONG));
+  feed(&parser, frame, length);
+  check("real chunk behind it parsed", parser.getState() == RESPONSE_PARSER_COMPLETE && parser.getLength() == length && parser.getFrame()[2] == 2);
+
+  // Without the command's bound the stray header swallows the real chunk as its payload
+  parser.expectChunked();
+  feed(&parser, TOO_LONG, sizeof(TOO_LONG));
+  feed(&parser, frame, length);
+  check("frame limit alone misses it", parser.getState() != RESPONSE_PARSER_COMPLETE);
+
+  // A chunk right at the bound is fine
+  length = makeChunk(frame, SETTINGS_CHUNK_MAX_DATA);
+  parser.expectChunked(SETTINGS_CHUNK_MAX_DATA);
+  feed(&parser, frame, length);
+  check("chunk at the bound parsed", parser.getState() == RESPONSE_PARSER_COMPLETE && parser.getResyncCount() == 0);
+}
+
+void checkProtocol() {
+  camera.powerOn();
+
+  RunCam::Protocol protocol(&camera);
+  protocol.waitUntilReady();
+
+  RunCam::SettingsStore store;
+
+  // The noise goes out just ahead of the camera's answer
+  camera.injectNoise(TOO_LONG, sizeof(TOO_LONG));
+  unsigned long start = millis();
+  int read = protocol.getSetting(0, &store);
+  unsigned long elapsed = millis() - start;
+
+  Serial.print("  settings read in ");
+  Serial.print(elapsed);
+  Serial.println("ms");
+
+  check("settings read behind the noise", read >= 0 && store.getCount() > 0);
+  check("no wait for the timeout", elapsed < RESPONSE_TIMEOUT_MS / 10);
+#ifndef RUNCAM_NO_STATS
+  check("resync counted", protocol.getStats()->resyncs == 1);
+#endif
+
+  // The queued interface uses the same bound
+  store.clear();
+  camera.injectNoise(TOO_LONG, sizeof(TOO_LONG));
+  protocol.submitReadSettingDetail(SETTINGID_DISP_RESOLUTION, 0, &store, NULL, NULL);
+  protocol.flush();
+
+  RunCam::SettingRecord *record = store.find(SETTINGID_DISP_RESOLUTION);
+  check("queued setting detail read behind the noise", record != NULL && record->detail.asTextSelection() != NULL);
+
+  // Display writes can go out while a detail read is in flight.  The detail still lands on the setting
+  // that was asked for.
+  store.clear();
+  bool begun = protocol.beginReadSettingDetail(SETTINGID_DISP_TV_MODE, 0);
+  protocol.displayWriteChar(3, 4, 'X');
+  protocol.displayFillRegion(0, 0, 2, 2, ' ');
+  while (protocol.poll() == RESPONSE_PARSER_PENDING) {
+    yield();
+  }
+  int remaining = protocol.endReadSettingDetail(&store);
+
+  record = store.find(SETTINGID_DISP_TV_MODE);
+  check("detail read across display writes", begun && remaining == 0 && record != NULL && record->detail.asTextSelection() != NULL);
+  check("no detail for the wrong setting", store.getCount() == 1);
+  check("display writes reached the camera", camera.getScreenChar(3, 4) == 'X');
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam Response Parser Test");
+
+  checkParser();
+  checkProtocol();
+
+  Serial.println(failures == 0 ? "All checks passed" : "Checks failed");
+}
+
+void loop() {
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Switches a simulated Split 4 between two known configurations with settings profiles, and compares that
+// with making the same changes through the one at a time setters.
+//
+// A profile only writes what differs from the cached settings, queues the writes back to back and only
+// reads settings again when the camera says a write changed others.  Applying the profile the camera is
+// already in costs no round trips at all.
+
+#include <Arduino.h>
+#include <RunCam_Split4.h>
+#include <SimulatedCamera.h>
+
+RunCam::SimulatedCamera camera;
+
+void printReport(const char *name, bool success, const RunCam::ProfileApplyReport *report) {
+  Serial.print(name);
+  Serial.print(success ? ": " : ": failed, ");
+  Serial.print(report->written);
+  Serial.print(" written, ");
+  Serial.print(report->unchanged);
+  Serial.print(" unchanged, ");
+  Serial.print(report->failed);
+  Serial.print(" failed, ");
+  Serial.print(report->reread);
+  Serial.print(" read again in ");
+  Serial.print(report->time);
+  Serial.println("us");
+}
+
+void printCamera() {
+  Serial.print("  Camera: ");
+  Serial.print(camera.getSetting(SETTINGID_DISP_TV_MODE)->value == 0 ? "NTSC" : "PAL");
+  Serial.print(" resolution ");
+  Serial.print(camera.getSetting(SETTINGID_DISP_RESOLUTION)->value);
+  Serial.print(" time ");
+  Serial.println(camera.getSetting(SETTINGID_DISP_CAMERA_TIME)->text);
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam Settings Profiles");
+
+  camera.powerOn();
+  RunCam::Split4 device(&camera);
+
+  RunCam::SettingsProfile day("day");
+  device.captureProfile(&day);
+  day.setText(SETTINGID_DISP_CAMERA_TIME, "2025-06-01 09:00:00");
+
+  // The same changes through the setters, each a blocking round trip, then the getters to bring the
+  // settings they invalidated up to date
+  unsigned long startTime = micros();
+  device.setDisplayMode("NTSC");
+  device.setResolution("720@60");
+  device.setCameraTime("2025-06-01 21:00:00");
+  device.getCharset();
+  device.getDisplayMode();
+  device.getResolution();
+  device.getDisplayColumns();
+  unsigned long setterTime = micros() - startTime;
+
+  Serial.print("Setters and getters: ");
+  Serial.print(setterTime);
+  Serial.println("us");
+  printCamera();
+
+  RunCam::SettingsProfile night("night");
+  device.captureProfile(&night);
+  night.setText(SETTINGID_DISP_CAMERA_TIME, "2025-06-01 21:00:00");
+
+  RunCam::ProfileApplyReport report;
+  bool success = device.applyProfile(&day, &report);
+  printReport(day.getName(), success, &report);
+  printCamera();
+
+  success = device.applyProfile(&day, &report);
+  printReport("day again", success, &report);
+
+  success = device.applyProfile(&night, &report);
+  printReport(night.getName(), success, &report);
+  printCamera();
+
+  // Only the time differs, and the camera doesn't flag it as changing anything else
+  night.setText(SETTINGID_DISP_CAMERA_TIME, "2025-06-02 21:00:00");
+  success = device.applyProfile(&night, &report);
+  printReport("night, new time", success, &report);
+  printCamera();
+
+  Serial.print("Getters after apply: ");
+  Serial.print(device.getDisplayMode());
+  Serial.print(" ");
+  Serial.print(device.getResolution());
+  Serial.print(" ");
+  Serial.println(device.getCameraTime());
+}
+
+void loop() {
+}
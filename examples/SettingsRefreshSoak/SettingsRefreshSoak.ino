@@ -0,0 +1,184 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Refreshes the settings of a simulated Split 4 over and over while its string settings change length, and
+// checks the settings store memory settles and then stays flat.  Runs on the board or on a host and prints
+// PASS or FAIL for each check.
+
+#include <Arduino.h>
+#include <RunCam_Split4.h>
+#include <SimulatedCamera.h>
+
+#define SETTLE_REFRESHES 40             // Enough for every string to have had every length
+#define SOAK_REFRESHES 400
+#define MAX_LENGTH 20                   // The simulated camera's longest string settings
+
+const uint8_t STRING_SETTINGS[] = { SETTINGID_DISP_SDCARD_CAPACITY, SETTINGID_DISP_REMAIN_RECORDING_TIME, SETTINGID_DISP_CAMERA_TIME };
+#define STRING_SETTING_COUNT (sizeof(STRING_SETTINGS) / sizeof(STRING_SETTINGS[0]))
+
+RunCam::SimulatedCamera camera;
+RunCam::Split4 *device;
+uint8_t failures = 0;
+unsigned long mismatches = 0;
+
+void check(const char *name, bool passed) {
+  Serial.print(passed ? "PASS " : "FAIL ");
+  Serial.println(name);
+  if (!passed) {
+    failures++;
+  }
+}
+
+// Each string gets a different length on each refresh, stepping through every length from 1 to MAX_LENGTH
+// every MAX_LENGTH refreshes
+void changeStrings(unsigned long refresh) {
+  for (uint8_t i = 0; i < STRING_SETTING_COUNT; i++) {
+    RunCam::SimulatedSetting *setting = camera.getSetting(STRING_SETTINGS[i]);
+    uint8_t length = 1 + (refresh * 7 + i * 5) % MAX_LENGTH;
+
+    for (uint8_t j = 0; j < length; j++) {
+      setting->text[j] = '0' + (refresh + j) % 10;
+    }
+    setting->text[length] = 0;
+  }
+}
+
+// Timeouts and errors so far.  A refresh that had one keeps some old values, which isn't what's checked.
+uint32_t getFailureCount() {
+#ifndef RUNCAM_NO_STATS
+  const RunCam::ProtocolStats *stats = device->getProtocol()->getStats();
+  return stats->timeouts + stats->errors;
+#else
+  return 0;
+#endif
+}
+
+// The store holds what the camera has for every string, both in the setting list and in the detail
+bool matchesCamera(RunCam::SettingsStore *settings) {
+  for (uint8_t i = 0; i < STRING_SETTING_COUNT; i++) {
+    const RunCam::SettingRecord *record = settings->find(STRING_SETTINGS[i]);
+    const char *text = camera.getSetting(STRING_SETTINGS[i])->text;
+
+    if (record == NULL || strcmp(settings->getValue(record), text) != 0 || strcmp(settings->getText(record), text) != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Values that outgrow their slot in a full pool squeeze out the slots outgrown before them
+void checkFullPool() {
+  RunCam::SettingsStore store;
+  uint8_t text[SETTINGS_STORE_POOL_SIZE / 4];
+  bool stored = true;
+
+  memset(text, 'x', sizeof(text));
+  for (uint8_t i = 0; i < 3; i++) {
+    store.add(i);
+  }
+
+  for (size_t length = 1; length <= sizeof(text); length++) {
+    for (uint8_t i = 0; i < 3; i++) {
+      RunCam::SettingRecord *record = store.get(i);
+
+      text[length - 1] = 'a' + i;
+      record->valueOffset = store.setString(record->valueOffset, text, length);
+      text[length - 1] = 'x';
+
+      const char *value = store.getValue(record);
+      if (record->valueOffset == SETTINGS_STORE_NO_STRING || strlen(value) != length || value[length - 1] != 'a' + i) {
+        stored = false;
+      }
+    }
+  }
+
+  check("growing values fit a full pool", stored);
+  check("pool holds only the values in use", store.getMemoryUsage() <= 3 * sizeof(RunCam::SettingRecord) + 3 * (sizeof(text) + 2));
+}
+
+// Changes the strings, refreshes and returns the store memory in use afterwards
+size_t refresh(unsigned long count) {
+  RunCam::SettingsStore *settings = device->getSettings();
+  uint32_t failureCount = getFailureCount();
+
+  changeStrings(count);
+  device->refreshSettings();
+
+  if (getFailureCount() == failureCount && !matchesCamera(settings)) {
+    mismatches++;
+  }
+
+  return settings->getMemoryUsage();
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam Settings Refresh Soak");
+
+  checkFullPool();
+
+  camera.powerOn();
+  device = new RunCam::Split4(&camera);
+
+  unsigned long count = 0;
+  size_t settledUsage = 0;
+
+  for (; count < SETTLE_REFRESHES; count++) {
+    size_t usage = refresh(count);
+    if (usage > settledUsage) {
+      settledUsage = usage;
+    }
+  }
+
+  size_t maxUsage = 0;
+  unsigned long growing = 0;
+
+  for (; count < SETTLE_REFRESHES + SOAK_REFRESHES; count++) {
+    size_t usage = refresh(count);
+    if (usage > maxUsage) {
+      maxUsage =
+ usage;
+    }
+    if (usage > settledUsage) {
+      growing++;
+    }
+  }
+
+  Serial.print("  ");
+  Serial.print(count);
+  Serial.print(" refreshes, settled at ");
+  Serial.print(settledUsage);
+  Serial.print(" bytes, then at most ");
+  Serial.print(maxUsage);
+  Serial.print(" bytes, peak ");
+  Serial.print(device->getSettings()->getPeakMemoryUsage());
+  Serial.println(" bytes");
+
+  // Outgrown strings left in the pool would fill it long before the values in use do
+  size_t settledPool = settledUsage - device->getSettings()->getCount() * sizeof(RunCam::SettingRecord);
+
+  check("every refresh read the camera's strings", mismatches == 0);
+  check("settled with room left in the pool", settledPool + MAX_LENGTH + 2 <= SETTINGS_STORE_POOL_SIZE);
+  check("memory stays flat after settling", growing == 0);
+
+  Serial.println(failures == 0 ? "All checks passed" : "Checks failed");
+}
+
+void loop() {
+}
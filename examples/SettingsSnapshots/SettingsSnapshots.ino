@@ -0,0 +1,158 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Reader threads watching a Split 4's settings while its own thread keeps refreshing and writing them.
+// Readers take snapshots instead of calling the getters, so they never see a refresh half done and never
+// wait for one.  Runs against a simulated camera, on Linux or an ESP32.
+//
+// Each reader checks that the resolution and the remaining recording time in every snapshot belong
+// together, since the camera changes both on each resolution write, and counts how many snapshots it read
+// and how long acquiring one took.
+
+#include <Arduino.h>
+#include <RunCam_Split4.h>
+#include <SimulatedCamera.h>
+
+#ifdef RUNCAM_HAS_ATOMIC
+
+#include <atomic>
+#include <thread>
+
+#define READER_COUNT 2
+#define WRITES 40
+
+struct ReaderReport {
+  uint32_t snapshots;
+  uint32_t versions;
+  uint32_t inconsistent;
+  unsigned long maxAcquire;
+};
+
+const char *RESOLUTIONS[] = { "1080@60", "1080@50", "1080@30", "720@60" };
+const char *RECORDING_TIMES[] = { "01:02:03", "01:14:27", "02:04:06", "02:19:40" };
+
+RunCam::SimulatedCamera camera;
+RunCam::Split4 *device;
+std::atomic<bool> stop(false);
+ReaderReport reports[READER_COUNT];
+
+void runReader(uint8_t index) {
+  ReaderReport *report = &reports[index];
+  uint32_t lastVersion = 0;
+
+  while (!stop.load()) {
+    unsigned long start = micros();
+    RunCam::SettingsSnapshot *snapshot = device->acquireSettings();
+    unsigned long acquire = micros() - start;
+    if (acquire > report->maxAcquire) {
+      report->maxAcquire = acquire;
+    }
+
+    if (snapshot == NULL) {
+      continue;
+    }
+
+    const char *resolution = snapshot->getSelectedOption(SETTINGID_DISP_RESOLUTION);
+    const char *recordingTime = snapshot->getValue(SETTINGID_DISP_REMAIN_RECORDING_TIME);
+    const RunCam::SettingRecord *resolutionRecord = snapshot->find(SETTINGID_DISP_RESOLUTION);
+    const RunCam::SettingRecord *timeRecord = snapshot->find(SETTINGID_DISP_REMAIN_RECORDING_TIME);
+
+    // Settings a write changed are marked stale until they are read again, only compare fresh ones
+    bool fresh = resolutionRecord != NULL && !resolutionRecord->stale && timeRecord != NULL && !timeRecord->stale;
+    for (uint8_t i = 0; i < 4 && fresh && resolution != NULL; i++) {
+      if (strcmp(resolution, RESOLUTIONS[i]) == 0 && strcmp(recordingTime, RECORDING_TIMES[i]) != 0) {
+        report->inconsistent++;
+      }
+    }
+
+    report->snapshots++;
+    if (snapshot->getVersion() != lastVersion) {
+      lastVersion = snapshot->getVersion();
+      report->versions++;
+    }
+
+    device->releaseSettings(snapshot);
+    yield();
+  }
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam Settings Snapshots");
+
+  camera.powerOn();
+  device = new RunCam::Split4(&camera);
+
+  std::thread readers[READER_COUNT];
+  for (uint8_t i = 0; i < READER_COUNT; i++) {
+    memset(&reports[i], 0, sizeof(reports[i]));
+    readers[i] = std::thread(runReader, i);
+  }
+
+  // Resolution writes change the remaining recording time, so the camera asks for a refresh after each
+  unsigned long startTime = millis();
+  for (uint8_t i = 0; i < WRITES; i++) {
+    device->setResolution(RESOLUTIONS[i % 4]);
+    device->getResolution();
+    device->getRemainingRecordingTime();
+    if (i % 10 == 9) {
+      device->refreshSettings();
+    }
+  }
+  unsigned long elapsed = millis() - startTime;
+
+  stop = true;
+  for (uint8_t i = 0; i < READER_COUNT; i++) {
+    readers[i].join();
+  }
+
+  Serial.print(WRITES);
+  Serial.print(" writes in ");
+  Serial.print(elapsed);
+  Serial.println("ms");
+
+  for (uint8_t i = 0; i < READER_COUNT; i++) {
+    Serial.print("Reader ");
+    Serial.print(i);
+    Serial.print(": ");
+    Serial.print(reports[i].snapshots);
+    Serial.print(" snapshots of ");
+    Serial.print(reports[i].versions);
+    Serial.print(" versions, ");
+    Serial.print(reports[i].inconsistent);
+    Serial.print(" inconsistent, slowest acquire ");
+    Serial.print(reports[i].maxAcquire);
+    Serial.println("us");
+  }
+
+  delete device;
+}
+
+#else
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("Settings snapshots need std::atomic");
+}
+
+#endif
+
+void loop() {
+}
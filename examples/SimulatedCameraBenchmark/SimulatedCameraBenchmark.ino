@@ -0,0 +1,257 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// End to end benchmarks against a simulated Split 4 modelled at 115200 baud.  Needs no camera attached, so
+// the numbers only depend on the library and the wire timing and can be compared between changes.
+//
+// Reports boot to ready time, per command latency, full settings refresh time and OSD frames per second.
+
+#include <Arduino.h>
+#include <RunCam_Split4.h>
+#include <OsdFrameBuffer.h>
+#include <SimulatedCamera.h>
+
+#define ITERATIONS 50
+#define REFRESH_ITERATIONS 10
+#define OSD_TEST_MS 2000
+
+RunCam::SimulatedCamera camera(115200);
+RunCam::SettingsStore settings;
+
+unsigned long minTime;
+unsigned long maxTime;
+unsigned long totalTime;
+unsigned long startTime;
+
+void beginSample() {
+  startTime = micros();
+}
+
+void endSample() {
+  unsigned long elapsed = micros() - startTime;
+
+  totalTime += elapsed;
+  if (elapsed < minTime) {
+    minTime = elapsed;
+  }
+  if (elapsed > maxTime) {
+    maxTime = elapsed;
+  }
+}
+
+void resetSamples() {
+  minTime = 0xffffffff;
+  maxTime = 0;
+  totalTime = 0;
+}
+
+void printSamples(const char *name, int count) {
+  Serial.print(name);
+  Serial.print(": avg ");
+  Serial.print(totalTime / count);
+  Serial.print("us min ");
+  Serial.print(minTime);
+  Serial.print("us max ");
+  Serial.print(maxTime);
+  Serial.println("us");
+}
+
+void benchmarkCommands(RunCam::Protocol *driver) {
+  uint8_t version;
+  uint16_t features;
+
+  resetSamples();
+  for (int i = 0; i < ITERATIONS; i++) {
+    beginSample();
+    driver->readCameraInfo(&version, &features);
+    endSample();
+  }
+  printSamples("Read camera info", ITERATIONS);
+
+  resetSamples();
+  for (int i = 0; i < ITERATIONS; i++) {
+    beginSample();
+    driver->getSetting(0, &settings);
+    endSample();
+  }
+  printSamples("Get settings chunk", ITERATIONS);
+
+  resetSamples();
+  for (int i = 0; i < ITERATIONS; i++) {
+    beginSample();
+    driver->readSettingDetail(SETTINGID_DISP_RESOLUTION, 0, &settings);
+    endSample();
+  }
+  printSamples("Read setting detail", ITERATIONS);
+
+  resetSamples();
+  for (int i = 0; i < ITERATIONS; i++) {
+    beginSample();
+    driver->writeSetting(SETTINGID_DISP_TV_MODE, i % 2);
+    endSample();
+  }
+  printSamples("Write setting", ITERATIONS);
+
+  resetSamples();
+  for (int i = 0; i < ITERATIONS; i++) {
+    beginSample();
+    driver->writeSetting(SETTINGID_DISP_CAMERA_TIME, "2025-01-01 12:00:00");
+    endSample();
+  }
+  printSamples("Write string setting", ITERATIONS);
+
+  driver->fiveKeySimulationConnection(RCDEVICE_PROTOCOL_5KEY_FUNCTION_OPEN);
+
+  resetSamples();
+  for (int i = 0; i < ITERATIONS; i++) {
+    beginSample();
+    driver->fiveKeySimulationPress(RCDEVICE_PROTOCOL_5KEY_SIMULATION_DOWN);
+    driver->fiveKeySimulationRelease();
+    endSample();
+  }
+  printSamples("Five key press and release", ITERATIONS);
+
+  driver->fiveKeySimulationConnection(RCDEVICE_PROTOCOL_5KEY_FUNCTION_CLOSE);
+}
+
+// The protocol's own counts for the same commands
+void printStats(const RunCam::ProtocolStats *stats) {
+  for (int i = 0; i < PROTOCOL_STATS_COMMANDS; i++) {
+    const RunCam::CommandStats *command = &stats->commands[i];
+    if (command->responses == 0) {
+      continue;
+    }
+
+    Serial.print("Command 0x");
+    Serial.print(command->command, HEX);
+    Serial.print(": ");
+    Serial.print(command->responses);
+    Serial.print(" responses, p50 < ");
+    Serial.print(RunCam::getLatencyPercentile(command, 50));
+    Serial.print("us, p99 < ");
+    Serial.print(RunCam::getLatencyPercentile(command, 99));
+    Serial.print("us, ");
+    Serial.print(command->timeouts);
+    Serial.print(" timeouts, ");
+    Serial.print(command->errors);
+    Serial.println(" errors");
+  }
+
+  Serial.print("Link: ");
+  Serial.print(stats->bytesSent);
+  Serial.print(" bytes sent, ");
+  Serial.print(stats->bytesReceived);
+  Serial.print(" received, ");
+  Serial.print(stats->retries);
+  Serial.println(" retries");
+}
+
+void benchmarkRefresh(RunCam::Split4 *device) {
+  resetSamples();
+  for (int i = 0; i < REFRESH_ITERATIONS; i++) {
+    beginSample();
+    device->refreshSettings();
+    endSample();
+  }
+  printSamples("Full settings refresh", REFRESH_ITERATIONS);
+}
+
+// A HUD with a few numbers changing every frame, committed as fast as the link allows
+void benchmarkOsd(RunCam::Protocol *driver) {
+  RunCam::OsdFrameBuffer osd(SIMULATED_CAMERA_COLUMNS, SIMULATED_CAMERA_ROWS);
+
+  osd.print(1, 1, "ALT");
+  osd.print(1, 2, "BAT");
+  osd.print(1, 3, "SPD");
+  osd.commit(driver);
+
+  unsigned long frames = 0;
+  unsigned long bytes = 0;
+  unsigned long start = millis();
+
+  while (millis() - start < OSD_TEST_MS) {
+    osd.print(5, 1, String(frames % 1000) + "m  ");
+    osd.print(5, 2, String(1680 - frames % 400) + "  ");
+    osd.print(5, 3, String((frames * 7) % 120) + "  ");
+    bytes += osd.commit(driver);
+    frames++;
+  }
+
+  camera.flush();
+  unsigned long elapsed = millis() - start;
+
+  Serial.print("OSD: ");
+  Serial.print(frames * 1000 / elapsed);
+  Serial.print(" frames/s, ");
+  Serial.print(bytes / frames);
+  Serial.println(" bytes/frame");
+
+  // Every cell changing to a different character each frame is the worst case
+  frames = 0;
+  start = millis();
+
+  while (millis() - start < OSD_TEST_MS) {
+    for (uint8_t y = 0; y < SIMULATED_CAMERA_ROWS; y++) {
+      for (uint8_t x = 0; x < SIMULATED_CAMERA_COLUMNS; x++) {
+        osd.setChar(x, y, 'A' + (x + y + frames) % 26);
+      }
+    }
+    osd.commit(driver);
+    frames++;
+  }
+
+  camera.flush();
+  elapsed = millis() - start;
+
+  Serial.print("OSD full redraw: ");
+  Serial.print(frames * 1000 / elapsed);
+  Serial.println(" frames/s");
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam Simulated Camera Benchmark");
+
+  camera.powerOn();
+  unsigned long start = millis();
+
+  RunCam::Protocol driver(&camera);
+  driver.waitUntilReady();
+
+  Serial.print("Boot to ready: ");
+  Serial.print(millis() - start);
+  Serial.print("ms, camera boots in ");
+  Serial.print(SIMULATED_CAMERA_DEFAULT_BOOT_MS);
+  Serial.println("ms");
+
+  driver.clearStats();
+  benchmarkCommands(&driver);
+  printStats(driver.getStats());
+  benchmarkOsd(&driver);
+
+  RunCam::Split4 device(&camera, DEFAULT_BAUD_RATE, NULL, SPLIT4_SETTINGS_LAZY);
+  benchmarkRefresh(&device);
+
+  Serial.print("Requests: ");
+  Serial.print(camera.getRequestCount());
+  Serial.print(", dropped bytes: ");
+  Serial.println(camera.getDroppedByteCount());
+}
+
+void loop() {
+}
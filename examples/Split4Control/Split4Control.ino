@@ -22,16 +22,24 @@
 
 RunCam::Split4* device;
 
+// Declared ahead so the sketch also builds as plain C++, where the IDE doesn't add prototypes
+void logSettings();
+void printHelp();
+
 void setup() {
   Serial.begin(1000000);
   while (!Serial);
 
   Serial.println("RunCam Split4 Control");
 
+  // Pass SPLIT4_SETTINGS_LAZY as the last argument to read each setting only when it is first used
   device = new RunCam::Split4(&Serial1);
 
   Serial.print("Device Version: ");
   Serial.println(device->getVersion());
+  Serial.print("Startup Time: ");
+  Serial.print(device->getStartupTime());
+  Serial.println("ms");
   logSettings();
   printHelp();
 }
@@ -100,6 +108,11 @@ void logSettings() {
 
   Serial.print("  Camera Time: ");
   Serial.println(device->getCameraTime());  
+
+  Serial.print("  Settings Memory: ");
+  Serial.print(device->getSettings()->getMemoryUsage());
+  Serial.print(" bytes, peak ");
+  Serial.println(device->getSettings()->getPeakMemoryUsage());
 }
 
 void printHelp() {
@@ -0,0 +1,202 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Several threads sharing one camera through ProtocolChannels, with a ProtocolWorker on its own I/O thread
+// owning the serial port.  Runs against a simulated Split 4 so it needs no camera, on Linux or an ESP32.
+//
+// Each client thread writes its own row of the OSD and reads the camera info, some requests one at a time
+// and some in bursts.  Checks that every result comes back to the thread that asked, in order, and reports
+// the request rate and how long clients waited.
+
+#include <Arduino.h>
+#include <ProtocolWorker.h>
+#include <SimulatedCamera.h>
+
+#ifdef RUNCAM_HAS_ATOMIC
+
+#include <atomic>
+#include <thread>
+
+#define CLIENT_COUNT 4
+#define REQUESTS_PER_CLIENT 500
+#define RESULT_TIMEOUT_MS 1000
+
+struct ClientReport {
+  uint32_t requests;
+  uint32_t failed;
+  uint32_t outOfOrder;
+  unsigned long totalWait;
+  unsigned long maxWait;
+};
+
+RunCam::SimulatedCamera camera;
+RunCam::ProtocolChannel channels[CLIENT_COUNT];
+ClientReport reports[CLIENT_COUNT];
+
+uint32_t makeRequest(RunCam::ProtocolChannel *channel, uint8_t row, uint32_t i) {
+  char text[16];
+
+  switch (i % 3) {
+    case 0:
+      return channel->readCameraInfo();
+    case 1:
+      snprintf(text, sizeof(text), "T%u %lu", row, (unsigned long)i);
+      return channel->displayWriteHorizontalString(0, row, text);
+    default:
+      return channel->displayWriteChar(29, row, '0' + i % 10);
+  }
+}
+
+bool collect(RunCam::ProtocolChannel *channel, ClientReport *report, uint32_t expectedId, unsigned long sentTime) {
+  RunCam::ChannelResult result;
+  if (!channel->waitForResult(&result, RESULT_TIMEOUT_MS)) {
+    report->failed++;
+    return false;
+  }
+
+  unsigned long wait = micros() - sentTime;
+  report->totalWait += wait;
+  if (wait > report->maxWait) {
+    report->maxWait = wait;
+  }
+
+  if (result.id != expectedId) {
+    report->outOfOrder++;
+  }
+  if (!result.result.success) {
+    report->failed++;
+  }
+
+  return true;
+}
+
+void runClient(uint8_t index) {
+  RunCam::ProtocolChannel *channel = &channels[index];
+  ClientReport *report = &reports[index];
+  uint8_t row = index + 1;
+
+  uint32_t i = 0;
+  while (i < REQUESTS_PER_CLIENT) {
+    // Alternate between one request at a time and filling the channel
+    uint8_t burst = (i / PROTOCOL_CHANNEL_SIZE) % 2 == 0 ? 1 : PROTOCOL_CHANNEL_SIZE;
+
+    uint32_t ids[PROTOCOL_CHANNEL_SIZE];
+    unsigned long sentTimes[PROTOCOL_CHANNEL_SIZE];
+    uint8_t sent = 0;
+    while (sent < burst && i < REQUESTS_PER_CLIENT) {
+      ids[sent] = makeRequest(channel, row, i);
+      if (ids[sent] == 0) {
+        break;
+      }
+      sentTimes[sent++] = micros();
+      i++;
+    }
+
+    for (uint8_t j = 0; j < sent; j++) {
+      collect(channel, report, ids[j], sentTimes[j]);
+    }
+    report->requests += sent;
+  }
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam Threaded Clients");
+
+  camera.powerOn();
+
+  // Before the I/O thread takes the Protocol over
+  RunCam::Protocol protocol(&camera);
+  protocol.waitUntilReady();
+
+  RunCam::ProtocolWorker worker(&protocol);
+  for (uint8_t i = 0; i < CLIENT_COUNT; i++) {
+    worker.attach(&channels[i]);
+    memset(&reports[i], 0, sizeof(reports[i]));
+  }
+
+  std::atomic<bool> stop(false);
+  std::thread io(&RunCam::ProtocolWorker::run, &worker, &stop);
+
+  unsigned long startTime = millis();
+
+  std::thread clients[CLIENT_COUNT];
+  for (uint8_t i = 0; i < CLIENT_COUNT; i++) {
+    clients[i] = std::thread(runClient, i);
+  }
+  for (uint8_t i = 0; i < CLIENT_COUNT; i++) {
+    clients[i].join();
+  }
+
+  unsigned long elapsed = millis() - startTime;
+
+  stop = true;
+  io.join();
+
+  uint32_t total = 0;
+  for (uint8_t i = 0; i < CLIENT_COUNT; i++) {
+    ClientReport *report = &reports[i];
+    total += report->requests;
+
+    Serial.print("Client ");
+    Serial.print(i);
+    Serial.print(": ");
+    Serial.print(report->requests);
+    Serial.print(" requests, ");
+    Serial.print(report->failed);
+    Serial.print(" failed, ");
+    Serial.print(report->outOfOrder);
+    Serial.print(" out of order, wait avg ");
+    Serial.print(report->requests > 0 ? report->totalWait / report->requests : 0);
+    Serial.print("us max ");
+    Serial.print(report->maxWait);
+    Serial.println("us");
+  }
+
+  Serial.print(total);
+  Serial.print(" requests in ");
+  Serial.print(elapsed);
+  Serial.print("ms, ");
+  Serial.print(total * 1000UL / elapsed);
+  Serial.println(" requests/s");
+
+  // Every client's last string should be on its row
+  for (uint8_t i = 0; i < CLIENT_COUNT; i++) {
+    Serial.print("Row ");
+    Serial.print(i + 1);
+    Serial.print(": ");
+    for (uint8_t x = 0; x < SIMULATED_CAMERA_COLUMNS; x++) {
+      Serial.print((char)camera.getScreenChar(x, i + 1));
+    }
+    Serial.println();
+  }
+}
+
+#else
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("Threaded clients need std::atomic");
+}
+
+#endif
+
+void loop() {
+}
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Keeps a trace of the traffic with the camera while reading its settings every second.  When a response
+// is corrupt or doesn't arrive the trace stops, is dumped as hex and recording starts again.
+//
+// Turn the hex back into bytes and pass them to TraceReplayer to reproduce the failure, see TraceReplay.
+
+#include <Arduino.h>
+#include <RunCam_Split4.h>
+#include <ProtocolTrace.h>
+
+// Prints each byte written to it as two hex digits
+class HexPrinter : public Print {
+  public:
+    HexPrinter(Print *out) {
+      _out = out;
+      _column = 0;
+    }
+
+    size_t write(uint8_t data) {
+      const char *digits = "0123456789abcdef";
+
+      _out->print(digits[data >> 4]);
+      _out->print(digits[data & 0xf]);
+
+      if (++_column == 32) {
+        _out->println();
+        _column = 0;
+      }
+
+      return 1;
+    }
+
+    using Print::write;
+
+  private:
+    Print *_out;
+    uint8_t _column;
+};
+
+RunCam::Split4* device;
+RunCam::ProtocolTrace trace;
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam Trace Capture");
+
+  trace.setStopOnError(true);
+
+  device = new RunCam::Split4(&Serial1);
+  device->getProtocol()->setTrace(&trace);
+}
+
+void loop() {
+  device->refreshSettings();
+
+  if (trace.isStopped()) {
+    Serial.print("Failure, trace of ");
+    Serial.print(trace.getCount());
+    Serial.print(" events, ");
+    Serial.print(trace.getOverwrittenCount());
+    Serial.println(" older events overwritten:");
+
+    HexPrinter hex(&Serial);
+    trace.write(&hex);
+    Serial.println();
+
+    trace.clear();
+  }
+
+  delay(1000);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Captures a settings refresh from a simulated camera and replays it through the response parser, first
+// as recorded and then with a short timeout to show which responses it would have cut off.  The replay is
+// also timed, which gives a parser benchmark over real traffic.
+//
+// A trace dumped by TraceCapture can be replayed the same way, on the board or on a host.
+
+#include <Arduino.h>
+#include <RunCam_Split4.h>
+#include <SimulatedCamera.h>
+#include <TraceReplayer.h>
+
+#define REPLAY_ITERATIONS 100
+#define SHORT_TIMEOUT_US 3000
+
+RunCam::SimulatedCamera camera;
+RunCam::ProtocolTrace trace;
+uint8_t capture[TRACE_HEADER_SIZE + PROTOCOL_TRACE_SIZE * TRACE_MAX_EVENT_SIZE];
+
+void printResponse(uint8_t state, const uint8_t *frame, uint8_t length, unsigned long time, void *context) {
+  if (state != RESPONSE_PARSER_COMPLETE) {
+    Serial.print("  ");
+    Serial.print(state == RESPONSE_PARSER_TIMEOUT ? "Timeout" : "Error");
+    Serial.print(" at ");
+    Serial.print(time);
+    Serial.print("us after ");
+    Serial.print(length);
+    Serial.println(" bytes");
+  }
+}
+
+void printStats(const RunCam::TraceReplayStats *stats) {
+  Serial.print("  ");
+  Serial.print(stats->responses);
+  Serial.print(" responses, ");
+  Serial.print(stats->complete);
+  Serial.print(" complete, ");
+  Serial.print(stats->errors);
+  Serial.print(" errors, ");
+  Serial.print(stats->timeouts);
+  Serial.print(" timeouts, ");
+  Serial.print(stats->mismatches);
+  Serial.println(" mismatches");
+}
+
+void setup() {
+  Serial.begin(1000000);
+  while (!Serial);
+
+  Serial.println("RunCam Trace Replay");
+
+  camera.powerOn();
+
+  RunCam::Split4 device(&camera, DEFAULT_BAUD_RATE, NULL, SPLIT4_SETTINGS_LAZY);
+  device.getProtocol()->setTrace(&trace);
+  device.refreshSettings();
+
+  size_t length = trace.encode(capture, sizeof(capture));
+
+  Serial.print("Captured ");
+  Serial.print(trace.getCount());
+  Serial.print(" events in ");
+  Serial.print(length);
+  Serial.println(" bytes");
+
+  RunCam::TraceReplayer replayer;
+  replayer.replay(capture, length);
+
+  Serial.println("As recorded:");
+  printStats(replayer.getStats());
+
+  RunCam::TraceReplayer shortTimeout(SHORT_TIMEOUT_US);
+  shortTimeout.setCallback(printResponse, NULL);
+  shortTimeout.replay(capture, length);
+
+  Serial.print("With a ");
+  Serial.print(SHORT_TIMEOUT_US);
+  Serial.println("us timeout:");
+  printStats(shortTimeout.getStats());
+
+  unsigned long start = micros();
+  for (int i = 0; i < REPLAY_ITERATIONS; i++) {
+    replayer.replay(capture, length);
+  }
+  unsigned long elapsed = micros() - start;
+
+  Serial.print("Replay: ");
+  Serial.print(elapsed / REPLAY_ITERATIONS);
+  Serial.print("us per trace, ");
+  Serial.print((unsigned long)((uint64_t)replayer.getStats()->rxBytes * REPLAY_ITERATIONS * 1000000 / elapsed));
+  Serial.println(" received bytes/s");
+}
+
+void loop() {
+}
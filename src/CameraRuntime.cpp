@@ -0,0 +1,251 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CameraRuntime.h"
+
+#ifdef RUNCAM_HAS_TERMIOS_TRANSPORT
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+namespace RunCam {
+
+  CameraRuntime::CameraRuntime() {
+    _epollFd = -1;
+    _linkCount = 0;
+    _linkEnd = 0;
+    memset(_links, 0, sizeof(_links));
+    clearStats();
+  }
+
+  CameraRuntime::~CameraRuntime() {
+    end();
+  }
+
+  bool CameraRuntime::begin() {
+    if (_epollFd >= 0) {
+      return true;
+    }
+
+    _epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epollFd < 0) {
+      return false;
+    }
+
+    // Links added before begin()
+    for (uint8_t i = 0; i < _linkEnd; i++) {
+      if (_links[i].protocol != NULL) {
+        watch(&_links[i]);
+      }
+    }
+
+    return true;
+  }
+
+  void CameraRuntime::end() {
+    if (_epollFd < 0) {
+      return;
+    }
+
+    close(_epollFd);
+    _epollFd = -1;
+
+    for (uint8_t i = 0; i < _linkEnd; i++) {
+      _links[i].fd = -1;
+    }
+  }
+
+  bool CameraRuntime::watch(Link *link) {
+    link->fd = link->port->getFd();
+    link->openCount = link->port->getOpenCount();
+    if (_epollFd < 0 || link->fd < 0) {
+      link->fd = -1;
+      return false;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u32 = link - _links;
+
+    if (epoll_ctl(_epollFd, EPOLL_CTL_ADD, link->fd, &event) != 0) {
+      link->fd = -1;
+      return false;
+    }
+
+    return true;
+  }
+
+  void CameraRuntime::unwatch(Link *link) {
+    // Fails harmlessly when the port has already closed the descriptor
+    if (_epollFd >= 0 && link->fd >= 0) {
+      epoll_ctl(_epollFd, EPOLL_CTL_DEL, link->fd, NULL);
+    }
+
+    link->fd = -1;
+  }
+
+  int CameraRuntime::addLink(Protocol *protocol, TermiosTransport *port) {
+    if (protocol == NULL || port == NULL) {
+      return -1;
+    }
+
+    for (uint8_t i = 0; i < CAMERA_RUNTIME_MAX_LINKS; i++) {
+      Link *link = &_links[i];
+      if (link->protocol != NULL) {
+        continue;
+      }
+
+      link->protocol = protocol;
+      link->port = port;
+      link->fd = -1;
+      watch(link);
+
+      _linkCount++;
+      if (i >= _linkEnd) {
+        _linkEnd = i + 1;
+      }
+
+      return i;
+    }
+
+    return -1;
+  }
+
+  bool CameraRuntime::removeLink(int link) {
+    if (link < 0 || link >= _linkEnd || _links[link].protocol == NULL) {
+      return false;
+    }
+
+    unwatch(&_links[link]);
+    _links[link].protocol = NULL;
+    _links[link].port = NULL;
+    _linkCount--;
+
+    while (_linkEnd > 0 && _links[_linkEnd - 1].protocol == NULL) {
+      _linkEnd--;
+    }
+
+    return true;
+  }
+
+  uint8_t CameraRuntime::getLinkCount() {
+    return _linkCount;
+  }
+
+  Protocol *CameraRuntime::getProtocol(int link) {
+    if (link < 0 || link >= _linkEnd) {
+      return NULL;
+    }
+
+    return _links[link].protocol;
+  }
+
+  // Milliseconds until the first link's deadline, rounded up so the deadline has passed on waking
+  int CameraRuntime::getWaitTime(int timeout) {
+    unsigned long delay = POLL_DELAY_NONE;
+    for (uint8_t i = 0; i < _linkEnd; i++) {
+      if (_links[i].protocol != NULL) {
+        unsigned long linkDelay = _links[i].protocol->getPollDelay();
+        if (linkDelay < delay) {
+          delay = linkDelay;
+        }
+      }
+    }
+
+    if (delay == POLL_DELAY_NONE) {
+      return timeout;
+    }
+
+    unsigned long wait = (delay + 999) / 1000;
+    if (timeout >= 0 && (unsigned long)timeout < wait) {
+      return timeout;
+    }
+
+    return wait;
+  }
+
+  int CameraRuntime::runOnce(int timeout) {
+    if (_epollFd < 0) {
+      return -1;
+    }
+
+    struct epoll_event events[CAMERA_RUNTIME_MAX_LINKS];
+    int count = epoll_wait(_epollFd, events, CAMERA_RUNTIME_MAX_LINKS, getWaitTime(timeout));
+    if (count < 0) {
+      return errno == EINTR ? 0 : -1;
+    }
+
+    _stats.wakeups++;
+
+    bool ready[CAMERA_RUNTIME_MAX_LINKS];
+    memset(ready, 0, _linkEnd);
+    for (int i = 0; i < count; i++) {
+      Link *link = &_links[events[i].data.u32];
+
+      // A port whose other end has gone away would wake every wait.  Its link carries on without being
+      // watched and its commands time out.
+      if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+        unwatch(link);
+      }
+
+      if (events[i].events & EPOLLIN) {
+        ready[events[i].data.u32] = true;
+        _stats.readyEvents++;
+      }
+    }
+
+    int polled = 0;
+    for (uint8_t i = 0; i < _linkEnd; i++) {
+      Link *link = &_links[i];
+      if (link->protocol == NULL || (!ready[i] && link->protocol->getPollDelay() != 0)) {
+        continue;
+      }
+
+      link->protocol->poll();
+      polled++;
+
+      // Changing baud rate reopens a port given by path, closing the watched descriptor
+      if (link->fd >= 0 && link->port->getOpenCount() != link->openCount) {
+        unwatch(link);
+        watch(link);
+      }
+    }
+
+    _stats.polls += polled;
+    return polled;
+  }
+
+  void CameraRuntime::run(volatile bool *stop) {
+    while (!*stop) {
+      if (runOnce(CAMERA_RUNTIME_RUN_WAIT_MS) < 0) {
+        break;
+      }
+    }
+  }
+
+  const CameraRuntimeStats *CameraRuntime::getStats() {
+    return &_stats;
+  }
+
+  void CameraRuntime::clearStats() {
+    memset(&_stats, 0, sizeof(_stats));
+  }
+
+}
+
+#endif
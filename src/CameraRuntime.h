@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __CAMERA_RUNTIME_H__
+#define __CAMERA_RUNTIME_H__
+
+#include "RunCam_Protocol.h"
+
+#ifdef RUNCAM_HAS_TERMIOS_TRANSPORT
+
+#ifndef CAMERA_RUNTIME_MAX_LINKS
+#define CAMERA_RUNTIME_MAX_LINKS 64
+#endif
+
+#define CAMERA_RUNTIME_RUN_WAIT_MS 100     // Longest run() sleeps before checking whether to stop
+
+namespace RunCam {
+
+  struct CameraRuntimeStats {
+    uint32_t wakeups;                     // Returns from epoll_wait
+    uint32_t readyEvents;                 // Ports that had bytes waiting
+    uint32_t polls;                       // Calls to Protocol::poll()
+  };
+
+  // Drives many cameras from one thread on Linux.  Each link is a Protocol on its own TermiosTransport, with
+  // the Protocol's resumable parser and command queue.  run() sleeps in epoll until a port has bytes or a
+  // link has a timeout, probe or queued command due, then polls only the links with something to do.
+  //
+  // Use the queued interface with callbacks.  The blocking calls would stall every other link, and the
+  // begin/end calls need the application to poll for them.  Writes go straight to the kernel's tty buffer,
+  // which holds far more than a request.
+  class CameraRuntime {
+    public:
+      CameraRuntime();
+      ~CameraRuntime();
+
+      // Creates the epoll instance.  false with errno set on failure.
+      bool begin();
+      void end();
+
+      // The protocol must have been constructed on the port.  Returns the link's index or -1.
+      int addLink(Protocol *protocol, TermiosTransport *port);
+      bool removeLink(int link);
+      uint8_t getLinkCount();
+      Protocol *getProtocol(int link);
+
+      // Wait up to timeout milliseconds (-1 for no limit) for work, then do it.  Returns the number of
+      // links polled, or -1 on error.
+      int runOnce(int timeout);
+
+      // Until *stop becomes true
+      void run(volatile bool *stop);
+
+      const CameraRuntimeStats *getStats();
+      void clearStats();
+
+    private:
+      struct Link {
+        Protocol *protocol;
+        TermiosTransport *port;
+        int fd;                           // As registered, -1 if not watched
+        uint32_t openCount;               // The port reopens on a baud rate change
+      };
+
+      int _epollFd;
+      Link _links[CAMERA_RUNTIME_MAX_LINKS];   // Free slots have no protocol
+      uint8_t _linkCount;
+      uint8_t _linkEnd;                   // One past the last slot in use
+      CameraRuntimeStats _stats;
+
+      bool watch(Link *link);
+      void unwatch(Link *link);
+      int getWaitTime(int timeout);
+  };
+
+}
+
+#endif
+
+#endif // __CAMERA_RUNTIME_H__
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "CommandQueue.h"
+
+namespace RunCam {
+
+  CommandQueue::CommandQueue() {
+    _head = 0;
+    _count = 0;
+    _nextHandle = 1;
+  }
+
+  QueuedCommand *CommandQueue::reserve() {
+    if (isFull()) {
+      return NULL;
+    }
+
+    QueuedCommand *command = &_commands[(_head + _count) % COMMAND_QUEUE_SIZE];
+    command->target = NULL;
+    command->targetType = COMMAND_TARGET_NONE;
+    command->callback = NULL;
+    command->context = NULL;
+
+    return command;
+  }
+
+  uint16_t CommandQueue::commit() {
+    QueuedCommand *command = &_commands[(_head + _count) % COMMAND_QUEUE_SIZE];
+
+    // Handle 0 is reserved to mean the command could not be queued
+    if (_nextHandle == 0) {
+      _nextHandle = 1;
+    }
+
+    command->handle = _nextHandle++;
+    _count++;
+
+    return command->handle;
+  }
+
+  QueuedCommand *CommandQueue::front() {
+    if (isEmpty()) {
+      return NULL;
+    }
+
+    return &_commands[_head];
+  }
+
+  void CommandQueue::pop() {
+    if (isEmpty()) {
+      return;
+    }
+
+    _head = (_head + 1) % COMMAND_QUEUE_SIZE;
+    _count--;
+  }
+
+  bool CommandQueue::isEmpty() {
+    return _count == 0;
+  }
+
+  bool CommandQueue::isFull() {
+    return _count == COMMAND_QUEUE_SIZE;
+  }
+
+  uint8_t CommandQueue::size() {
+    return _count;
+  }
+
+}
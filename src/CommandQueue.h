@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __COMMAND_QUEUE_H__
+#define __COMMAND_QUEUE_H__
+
+#include <Arduino.h>
+
+#ifndef COMMAND_QUEUE_SIZE
+#define COMMAND_QUEUE_SIZE 8
+#endif
+
+#define COMMAND_BUFF_SIZE 65
+
+#define RESPONSE_LENGTH_NONE     0      // The device does not reply to the command
+#define RESPONSE_LENGTH_CHUNKED  0xff   // The reply length is carried in the reply itself
+
+#define RESPONSE_COMMAND_COUNT   7      // Commands the device replies to, see Protocol::RESPONSE_COMMANDS
+
+#define COMMAND_TARGET_NONE   0
+#define COMMAND_TARGET_VECTOR 1         // target is a std::vector of Setting*
+#define COMMAND_TARGET_STORE  2         // target is a SettingsStore
+
+namespace RunCam {
+
+  class Setting;
+
+  // The decoded outcome of a queued command, handed to its completion callback
+  struct CommandResult {
+    uint16_t handle;
+    uint8_t command;
+    bool success;
+
+    // COMMAND_READ_CAMERA_INFO
+    uint8_t version;
+    uint16_t features;
+
+    // COMMAND_GET_SETTINGS and COMMAND_READ_SETTING_DETAIL
+    int remainingChunks;
+
+    // COMMAND_WRITE_SETTING
+    uint8_t resultCode;
+    uint8_t refresh;
+  };
+
+  typedef void (*CommandCallbackFuncPtr)(const CommandResult &result, void *context);
+
+  struct QueuedCommand {
+    uint16_t handle;
+    uint8_t length;
+    uint8_t responseLength;
+    uint8_t maxChunkData;           // Longest chunk payload when responseLength is RESPONSE_LENGTH_CHUNKED
+    uint8_t buf[COMMAND_BUFF_SIZE];
+
+    // Where setting and setting detail responses are decoded to
+    void *target;
+    uint8_t targetType;
+
+    CommandCallbackFuncPtr callback;
+    void *context;
+  };
+
+  // Fixed size FIFO of encoded commands waiting to be sent
+  class CommandQueue {
+    public:
+      CommandQueue();
+
+      // Returns the next free slot, or NULL if the queue is full.  The slot is not part of the queue until
+      // commit() is called so a command that fails to encode can simply be abandoned.
+      QueuedCommand *reserve();
+      uint16_t commit();
+
+      QueuedCommand *front();
+      void pop();
+
+      bool isEmpty();
+      bool isFull();
+      uint8_t size();
+
+    private:
+      QueuedCommand _commands[COMMAND_QUEUE_SIZE];
+      uint8_t _head;
+      uint8_t _count;
+      uint16_t _nextHandle;
+  };
+
+}
+
+#endif // __COMMAND_QUEUE_H__
@@ -14,30 +14,27 @@
  * limitations under the License.
  */
 
-#ifndef __UINT16_SETTING_DETAIL_H__
-#define __UINT16_SETTING_DETAIL_H__
+#ifndef __CRC8_H__
+#define __CRC8_H__
 
 #include <Arduino.h>
-#include "SettingDetail.h"
 
 namespace RunCam {
 
-  class UInt16SettingDetail : public SettingDetail {
+  // CRC8 with polynomial 0xd5 as used by the RunCam device protocol.
+  // Uses a 256 entry lookup table so each byte costs a single table load instead of an 8 step bit loop.
+  class Crc8 {
     public:
-      UInt16SettingDetail(uint8_t settingId, uint8_t settingType, uint16_t value, uint16_t min, uint16_t max, uint16_t stepSize);
-
-      uint16_t getValue();
-      uint16_t getMin();
-      uint16_t getMax();
-      uint16_t getStepSize();
-
-    private:
-      uint16_t _value;
-      uint16_t _min;
-      uint16_t _max;
-      uint16_t _stepSize;
+      static const uint8_t TABLE[256];
+
+      // Fold a single byte into a running crc.  Start with a crc of 0.
+      static inline uint8_t update(uint8_t crc, uint8_t data) {
+        return TABLE[crc ^ data];
+      }
+
+      static uint8_t calc(const uint8_t *buf, size_t numBytes);
   };
 
 }
 
-#endif // __UINT16_SETTING_DETAIL_H__
\ No newline at end of file
+#endif // __CRC8_H__
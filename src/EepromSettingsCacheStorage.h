@@ -0,0 +1,79 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __EEPROM_SETTINGS_CACHE_STORAGE_H__
+#define __EEPROM_SETTINGS_CACHE_STORAGE_H__
+
+// Keeps the settings cache in the board's EEPROM, or its emulation in flash.  This header is not included
+// by the library itself so boards without an EEPROM library still build; include it from the sketch.
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "SettingsCacheStorage.h"
+
+namespace RunCam {
+
+  class EepromSettingsCacheStorage : public SettingsCacheStorage {
+    public:
+      // Uses size bytes of EEPROM starting at address
+      EepromSettingsCacheStorage(int address, size_t size) {
+        _address = address;
+        _size = size;
+      }
+
+      size_t read(size_t offset, uint8_t *data, size_t length) {
+        if (offset + length > _size) {
+          return 0;
+        }
+
+        for (size_t i = 0; i < length; i++) {
+          data[i] = EEPROM.read(_address + offset + i);
+        }
+
+        return length;
+      }
+
+      size_t write(size_t offset, const uint8_t *data, size_t length) {
+        if (offset + length > _size) {
+          return 0;
+        }
+
+        // Only write bytes that changed, EEPROM cells wear out
+        for (size_t i = 0; i < length; i++) {
+          if (EEPROM.read(_address + offset + i) != data[i]) {
+            EEPROM.write(_address + offset + i, data[i]);
+          }
+        }
+
+        return length;
+      }
+
+      bool commit() {
+#if defined(ESP8266) || defined(ESP32)
+        return EEPROM.commit();
+#else
+        return true;
+#endif
+      }
+
+    private:
+      int _address;
+      size_t _size;
+  };
+
+}
+
+#endif // __EEPROM_SETTINGS_CACHE_STORAGE_H__
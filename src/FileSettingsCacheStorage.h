@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __FILE_SETTINGS_CACHE_STORAGE_H__
+#define __FILE_SETTINGS_CACHE_STORAGE_H__
+
+// Keeps the settings cache in a file, for hosts with a C library file system such as Linux.  This header
+// is not included by the library itself; include it where it is used.
+
+#include <Arduino.h>
+#include <stdio.h>
+#include "SettingsCacheStorage.h"
+
+namespace RunCam {
+
+  class FileSettingsCacheStorage : public SettingsCacheStorage {
+    public:
+      FileSettingsCacheStorage(const char *path) {
+        _path = path;
+        _file = NULL;
+      }
+
+      ~FileSettingsCacheStorage() {
+        close();
+      }
+
+      size_t read(size_t offset, uint8_t *data, size_t length) {
+        if (!open("rb") || fseek(_file, offset, SEEK_SET) != 0) {
+          return 0;
+        }
+
+        return fread(data, 1, length, _file);
+      }
+
+      size_t write(size_t offset, const uint8_t *data, size_t length) {
+        // Rewritten from the start each time so a shorter cache leaves nothing stale behind
+        if (offset == 0) {
+          close();
+        }
+
+        if (!open("wb") || fseek(_file, offset, SEEK_SET) != 0) {
+          return 0;
+        }
+
+        return fwrite(data, 1, length, _file);
+      }
+
+      bool commit() {
+        bool success = _file != NULL && fflush(_file) == 0;
+        close();
+        return success;
+      }
+
+    private:
+      const char *_path;
+      FILE *_file;
+      const char *_mode;
+
+      bool open(const char *mode) {
+        if (_file != NULL && strcmp(_mode, mode) != 0) {
+          close();
+        }
+
+        if (_file == NULL) {
+          _file = fopen(_path, mode);
+          _mode = mode;
+        }
+
+        return _file != NULL;
+      }
+
+      void close() {
+        if (_file != NULL) {
+          fclose(_file);
+          _file = NULL;
+        }
+      }
+  };
+
+}
+
+#endif // __FILE_SETTINGS_CACHE_STORAGE_H__
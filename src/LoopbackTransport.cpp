@@ -0,0 +1,126 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoopbackTransport.h"
+
+namespace RunCam {
+
+  LoopbackTransport::LoopbackTransport() {
+    _peer = NULL;
+    _baudRate = 0;
+    _rxHead = 0;
+    _rxCount = 0;
+    _dropped = 0;
+  }
+
+  void LoopbackTransport::connect(LoopbackTransport *peer) {
+    _peer = peer;
+    if (peer != NULL) {
+      peer->_peer = this;
+    }
+  }
+
+  LoopbackTransport *LoopbackTransport::getPeer() {
+    return _peer;
+  }
+
+  unsigned long LoopbackTransport::getBaudRate() {
+    return _baudRate;
+  }
+
+  uint32_t LoopbackTransport::getDroppedCount() {
+    return _dropped;
+  }
+
+  bool LoopbackTransport::receive(uint8_t data, unsigned long baudRate) {
+    if (_baudRate == 0 || _baudRate != baudRate || _rxCount == LOOPBACK_TRANSPORT_BUFFER_SIZE) {
+      _dropped++;
+      return false;
+    }
+
+    _rxBuf[(_rxHead + _rxCount) % LOOPBACK_TRANSPORT_BUFFER_SIZE] = data;
+    _rxCount++;
+    return true;
+  }
+
+  void LoopbackTransport::begin(unsigned long baudRate) {
+    begin(baudRate, SERIAL_8N1);
+  }
+
+  void LoopbackTransport::begin(unsigned long baudRate, uint16_t /* config */) {
+    _baudRate = baudRate;
+    _rxHead = 0;
+    _rxCount = 0;
+  }
+
+  void LoopbackTransport::end() {
+    _baudRate = 0;
+    _rxCount = 0;
+  }
+
+  int LoopbackTransport::available() {
+    return _rxCount;
+  }
+
+  int LoopbackTransport::peek() {
+    if (_rxCount == 0) {
+      return -1;
+    }
+
+    return _rxBuf[_rxHead];
+  }
+
+  int LoopbackTransport::read() {
+    if (_rxCount == 0) {
+      return -1;
+    }
+
+    uint8_t data = _rxBuf[_rxHead];
+    _rxHead = (_rxHead + 1) % LOOPBACK_TRANSPORT_BUFFER_SIZE;
+    _rxCount--;
+    return data;
+  }
+
+  void LoopbackTransport::flush() {
+    // Writes are delivered as they are made
+  }
+
+  size_t LoopbackTransport::write(uint8_t data) {
+    return write(&data, 1);
+  }
+
+  size_t LoopbackTransport::write(const uint8_t *buffer, size_t size) {
+    if (_baudRate == 0) {
+      return 0;
+    }
+
+    // Like a UART, the bytes are sent whether or not anything receives them
+    for (size_t i = 0; i < size; i++) {
+      if (_peer == NULL) {
+        _dropped++;
+      } else {
+        _peer->receive(buffer[i], _baudRate);
+      }
+    }
+
+    return size;
+  }
+
+  LoopbackTransport::operator bool() {
+    return _baudRate != 0;
+  }
+
+}
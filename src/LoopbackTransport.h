@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LOOPBACK_TRANSPORT_H__
+#define __LOOPBACK_TRANSPORT_H__
+
+#include <Arduino.h>
+
+#ifndef LOOPBACK_TRANSPORT_BUFFER_SIZE
+#define LOOPBACK_TRANSPORT_BUFFER_SIZE 256      // Bytes waiting to be read at each end
+#endif
+
+namespace RunCam {
+
+  // One end of an in-memory serial link.  Connect two of them and what is written to one can be read from
+  // the other straight away, with no wire timing.  Like a real link, bytes are lost when the receiving end
+  // has not begun, is at a different baud rate or has a full buffer.
+  //
+  // Both ends must be used from the same thread.
+  class LoopbackTransport final : public HardwareSerial {
+    public:
+      LoopbackTransport();
+
+      // Connects both ends to each other
+      void connect(LoopbackTransport *peer);
+      LoopbackTransport *getPeer();
+
+      unsigned long getBaudRate();
+      uint32_t getDroppedCount();           // Lost on the way to this end, or sent with no peer connected
+
+      // HardwareSerial
+      void begin(unsigned long baudRate);
+      void begin(unsigned long baudRate, uint16_t config);
+      void end();
+      int available();
+      int peek();
+      int read();
+      void flush();
+      size_t write(uint8_t data);
+      size_t write(const uint8_t *buffer, size_t size);
+      using Print::write;
+      operator bool();
+
+    private:
+      LoopbackTransport *_peer;
+      unsigned long _baudRate;              // 0 when ended
+      uint8_t _rxBuf[LOOPBACK_TRANSPORT_BUFFER_SIZE];
+      uint16_t _rxHead;
+      uint16_t _rxCount;
+      uint32_t _dropped;
+
+      bool receive(uint8_t data, unsigned long baudRate);
+  };
+
+}
+
+#endif // __LOOPBACK_TRANSPORT_H__
@@ -0,0 +1,186 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OsdFrameBuffer.h"
+
+namespace RunCam {
+
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+  OsdFrameBuffer::OsdFrameBuffer(uint8_t columns, uint8_t rows) : _planner(columns, rows) {
+    _columns = columns;
+    _rows = rows;
+    _cells = new uint8_t[_columns * _rows];
+    _sent = new uint8_t[_columns * _rows];
+    _ownsBuffers = true;
+
+    clear();
+    invalidate();
+  }
+#endif
+
+  // The buffer holds the cells, then what was sent, then the planner's scratch
+  OsdFrameBuffer::OsdFrameBuffer(uint8_t columns, uint8_t rows, uint8_t *buffer) : _planner(columns, rows, buffer + 2 * columns * rows) {
+    _columns = columns;
+    _rows = rows;
+    _cells = buffer;
+    _sent = buffer + _columns * _rows;
+    _ownsBuffers = false;
+
+    clear();
+    invalidate();
+  }
+
+  OsdFrameBuffer::~OsdFrameBuffer() {
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+    if (_ownsBuffers) {
+      delete[] _cells;
+      delete[] _sent;
+    }
+#endif
+  }
+
+  uint8_t OsdFrameBuffer::getRowCount(const String &tvMode) {
+    if (tvMode == "NTSC") {
+      return OSD_ROWS_NTSC;
+    }
+
+    return OSD_ROWS_PAL;
+  }
+
+  uint8_t OsdFrameBuffer::getColumns() {
+    return _columns;
+  }
+
+  uint8_t OsdFrameBuffer::getRows() {
+    return _rows;
+  }
+
+  void OsdFrameBuffer::clear() {
+    fill(0, 0, _columns, _rows, OSD_BLANK_CHAR);
+  }
+
+  void OsdFrameBuffer::setChar(uint8_t x, uint8_t y, uint8_t character) {
+    if (x >= _columns || y >= _rows) {
+      return;
+    }
+
+    _cells[y * _columns + x] = character;
+  }
+
+  uint8_t OsdFrameBuffer::getChar(uint8_t x, uint8_t y) {
+    if (x >= _columns || y >= _rows) {
+      return OSD_BLANK_CHAR;
+    }
+
+    return _cells[y * _columns + x];
+  }
+
+  // Strings are clipped at the edge of the screen
+  void OsdFrameBuffer::print(uint8_t x, uint8_t y, const String &string) {
+    for (unsigned int i = 0; i < string.length() && x + i < _columns; i++) {
+      setChar(x + i, y, string[i]);
+    }
+  }
+
+  void OsdFrameBuffer::printVertical(uint8_t x, uint8_t y, const String &string) {
+    for (unsigned int i = 0; i < string.length() && y + i < _rows; i++) {
+      setChar(x, y + i, string[i]);
+    }
+  }
+
+  void OsdFrameBuffer::fill(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character) {
+    for (uint8_t row = y; row < y + height && row < _rows; row++) {
+      for (uint8_t column = x; column < x + width && column < _columns; column++) {
+        _cells[row * _columns + column] = character;
+      }
+    }
+  }
+
+  bool OsdFrameBuffer::isDirty() {
+    return !_valid || memcmp(_cells, _sent, _columns * _rows) != 0;
+  }
+
+  bool OsdFrameBuffer::isDirty(uint8_t x, uint8_t y) {
+    if (x >= _columns || y >= _rows) {
+      return false;
+    }
+
+    size_t i = y * _columns + x;
+
+    return _cells[i] != _sent[i];
+  }
+
+  void OsdFrameBuffer::invalidate() {
+    _valid = false;
+  }
+
+  // The camera could be showing anything so start from a blank screen
+  size_t OsdFrameBuffer::clearScreen(Protocol *protocol) {
+    if (protocol != NULL) {
+      protocol->displayFillRegion(0, 0, _columns, _rows, OSD_BLANK_CHAR);
+    }
+
+    memset(_sent, OSD_BLANK_CHAR, _columns * _rows);
+    _valid = true;
+
+    return OSD_COST_FILL_REGION;
+  }
+
+  size_t OsdFrameBuffer::commit(Protocol *protocol) {
+    return commit(protocol, 0, 0, _columns, _rows);
+  }
+
+  size_t OsdFrameBuffer::commit(Protocol *protocol, uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    size_t bytesSent = 0;
+
+    if (!_valid) {
+      bytesSent += clearScreen(protocol);
+    }
+
+    bytesSent += _planner.plan(_cells, _sent, x, y, width, height, protocol);
+
+    for (uint8_t row = y; row < y + height && row < _rows; row++) {
+      size_t start = row * _columns + x;
+      size_t length = x + width <= _columns ? width : _columns - x;
+
+      if (x < _columns) {
+        memcpy(&_sent[start], &_cells[start], length);
+      }
+    }
+
+    return bytesSent;
+  }
+
+  size_t OsdFrameBuffer::getCommitCost() {
+    return getCommitCost(0, 0, _columns, _rows);
+  }
+
+  size_t OsdFrameBuffer::getCommitCost(uint8_t x, uint8_t y, uint8_t width, uint8_t height) {
+    if (!_valid) {
+      // Nothing is known about the camera screen so compare against the blank screen commit starts from
+      memset(_sent, OSD_BLANK_CHAR, _columns * _rows);
+
+      return OSD_COST_FILL_REGION + _planner.plan(_cells, _sent, x, y, width, height, NULL);
+    }
+
+    return _planner.plan(_cells, _sent, x, y, width, height, NULL);
+  }
+
+  OsdPlanStats OsdFrameBuffer::getPlanStats() {
+    return _planner.getStats();
+  }
+
+}
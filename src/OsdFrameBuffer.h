@@ -0,0 +1,92 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OSD_FRAME_BUFFER_H__
+#define __OSD_FRAME_BUFFER_H__
+
+#include <Arduino.h>
+#include "RunCam_Protocol.h"
+#include "OsdPlanner.h"
+
+#define OSD_ROWS_PAL 16
+#define OSD_ROWS_NTSC 13
+
+#define OSD_BLANK_CHAR ' '
+
+// Bytes needed by a frame buffer that uses a caller supplied buffer
+#define OSD_FRAME_BUFFER_SIZE(columns, rows) (3 * (columns) * (rows))
+
+namespace RunCam {
+
+  // Shadow copy of the camera OSD.  Apps draw into the frame buffer and commit() sends only the cells
+  // that differ from what was last sent to the camera, using the OsdPlanner to pick the commands.
+  class OsdFrameBuffer {
+    public:
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+      OsdFrameBuffer(uint8_t columns, uint8_t rows);
+#endif
+      // Uses OSD_FRAME_BUFFER_SIZE(columns, rows) bytes of the caller's buffer instead of allocating
+      OsdFrameBuffer(uint8_t columns, uint8_t rows, uint8_t *buffer);
+      ~OsdFrameBuffer();
+
+      // Number of OSD rows for the TV mode reported by Split4::getDisplayMode()
+      static uint8_t getRowCount(const String &tvMode);
+
+      uint8_t getColumns();
+      uint8_t getRows();
+
+      void clear();
+      void setChar(uint8_t x, uint8_t y, uint8_t character);
+      uint8_t getChar(uint8_t x, uint8_t y);
+      void print(uint8_t x, uint8_t y, const String &string);
+      void printVertical(uint8_t x, uint8_t y, const String &string);
+      void fill(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character);
+
+      bool isDirty();
+      bool isDirty(uint8_t x, uint8_t y);
+
+      // Forget what the camera is showing so the next commit clears the screen and redraws everything
+      void invalidate();
+
+      // Send the changed cells.  Returns the number of bytes written to the camera.  Passing a NULL protocol
+      // marks the frame as sent without sending anything.
+      size_t commit(Protocol *protocol);
+
+      // Bytes the next commit would send, without sending anything
+      size_t getCommitCost();
+
+      // As commit() and getCommitCost() but limited to a region of the screen
+      size_t commit(Protocol *protocol, uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+      size_t getCommitCost(uint8_t x, uint8_t y, uint8_t width, uint8_t height);
+
+      // Breakdown of the commands chosen by the last commit or getCommitCost()
+      OsdPlanStats getPlanStats();
+
+    private:
+      uint8_t _columns;
+      uint8_t _rows;
+      uint8_t *_cells;        // What the app wants on screen
+      uint8_t *_sent;         // What the camera is showing
+      bool _valid;
+      bool _ownsBuffers;
+      OsdPlanner _planner;
+
+      size_t clearScreen(Protocol *protocol);
+  };
+
+}
+
+#endif // __OSD_FRAME_BUFFER_H__
@@ -0,0 +1,344 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OsdPlanner.h"
+
+namespace RunCam {
+
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+  OsdPlanner::OsdPlanner(uint8_t columns, uint8_t rows) {
+    _columns = columns;
+    _rows = rows;
+    _covered = new uint8_t[columns * rows];
+    _ownsCovered = true;
+    memset(&_stats, 0, sizeof(_stats));
+  }
+#endif
+
+  OsdPlanner::OsdPlanner(uint8_t columns, uint8_t rows, uint8_t *covered) {
+    _columns = columns;
+    _rows = rows;
+    _covered = covered;
+    _ownsCovered = false;
+    memset(&_stats, 0, sizeof(_stats));
+  }
+
+  OsdPlanner::~OsdPlanner() {
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+    if (_ownsCovered) {
+      delete[] _covered;
+    }
+#endif
+  }
+
+  OsdPlanStats OsdPlanner::getStats() {
+    return _stats;
+  }
+
+  size_t OsdPlanner::plan(const uint8_t *cells, const uint8_t *sent, Protocol *protocol) {
+    return plan(cells, sent, 0, 0, _columns, _rows, protocol);
+  }
+
+  size_t OsdPlanner::plan(const uint8_t *cells, const uint8_t *sent, uint8_t x, uint8_t y, uint8_t width, uint8_t height, Protocol *protocol) {
+    _cells = cells;
+    _sent = sent;
+    _protocol = protocol;
+    _x0 = x < _columns ? x : _columns;
+    _y0 = y < _rows ? y : _rows;
+    _x1 = x + width < _columns ? x + width : _columns;
+    _y1 = y + height < _rows ? y + height : _rows;
+    _batchLength = 0;
+
+    memset(&_stats, 0, sizeof(_stats));
+    memset(_covered, 0, _columns * _rows);
+
+    planFills();
+    planHorizontalRuns();
+    planVerticalRuns();
+    planScattered();
+
+    return _stats.bytes;
+  }
+
+  bool OsdPlanner::needsSending(uint8_t x, uint8_t y) {
+    size_t i = y * _columns + x;
+
+    return _cells[i] != _sent[i] && !_covered[i];
+  }
+
+  void OsdPlanner::cover(uint8_t x, uint8_t y) {
+    _covered[y * _columns + x] = 1;
+  }
+
+  void OsdPlanner::planFills() {
+    // A region showing one character throughout, such as a cleared screen, is a single fill however its
+    // dirty cells lie.  Growing fills from the first dirty cell would split it around the clean ones.
+    if (_x0 >= _x1 || _y0 >= _y1) {
+      return;
+    }
+
+    uint8_t first = _cells[_y0 * _columns + _x0];
+    bool uniform = true;
+    for (uint8_t y = _y0; y < _y1 && uniform; y++) {
+      for (uint8_t x = _x0; x < _x1 && uniform; x++) {
+        uniform = _cells[y * _columns + x] == first;
+      }
+    }
+
+    if (uniform && tryFill(_x0, _y0, _x1 - _x0, _y1 - _y0, first)) {
+      return;
+    }
+
+    for (uint8_t y = _y0; y < _y1; y++) {
+      for (uint8_t x = _x0; x < _x1; x++) {
+        if (!needsSending(x, y)) {
+          continue;
+        }
+
+        // Grow the largest run of this character to the right, then as many rows down as match.  Clean
+        // cells that already show the character can be included as rewriting them changes nothing.
+        uint8_t c = _cells[y * _columns + x];
+
+        uint8_t width = 1;
+        while (x + width < _x1 && _cells[y * _columns + x + width] == c) {
+          width++;
+        }
+
+        uint8_t height = 1;
+        while (y + height < _y1) {
+          const uint8_t *row = &_cells[(y + height) * _columns + x];
+
+          uint8_t i = 0;
+          while (i < width && row[i] == c) {
+            i++;
+          }
+
+          if (i < width) {
+            break;
+          }
+
+          height++;
+        }
+
+        tryFill(x, y, width, height, c);
+      }
+    }
+  }
+
+  // Sends the rectangle as a fill if that is cheaper than strings or scattered cells for its dirty cells.
+  // Every cell in it must already hold c.
+  bool OsdPlanner::tryFill(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t c) {
+    // What the same cells would cost as one string per row, or as scattered cells
+    size_t dirtyCount = 0;
+    size_t stringCost = 0;
+    for (uint8_t row = y; row < y + height; row++) {
+      int first = -1;
+      int last = -1;
+      for (uint8_t column = x; column < x + width; column++) {
+        if (needsSending(column, row)) {
+          if (first < 0) {
+            first = column;
+          }
+          last = column;
+          dirtyCount++;
+        }
+      }
+
+      if (first >= 0) {
+        stringCost += OSD_COST_STRING_BASE + last - first + 1;
+      }
+    }
+
+    size_t scatteredCost = OSD_COST_CHAR_AT_POS_BASE + 3 * dirtyCount;
+    if (dirtyCount == 1) {
+      scatteredCost = OSD_COST_WRITE_CHAR;
+    }
+
+    if (OSD_COST_FILL_REGION >= stringCost || OSD_COST_FILL_REGION >= scatteredCost) {
+      return false;
+    }
+
+    if (_protocol != NULL) {
+      _protocol->displayFillRegion(x, y, width, height, c);
+    }
+
+    _stats.fills++;
+    _stats.bytes += OSD_COST_FILL_REGION;
+
+    for (uint8_t row = y; row < y + height; row++) {
+      for (uint8_t column = x; column < x + width; column++) {
+        cover(column, row);
+      }
+    }
+
+    return true;
+  }
+
+  void OsdPlanner::planHorizontalRuns() {
+    for (uint8_t y = _y0; y < _y1; y++) {
+      uint8_t x = _x0;
+
+      while (x < _x1) {
+        if (!needsSending(x, y)) {
+          x++;
+          continue;
+        }
+
+        // Extend the run over short gaps.  Resending a gap cell costs a byte, starting a new command costs 6.
+        uint8_t start = x;
+        uint8_t end = x + 1;
+        uint8_t dirtyCount = 1;
+        uint8_t gap = 0;
+        for (uint8_t i = end; i < _x1 && i - start < OSD_MAX_HORIZONTAL_LENGTH && gap < OSD_COST_STRING_BASE; i++) {
+          if (needsSending(i, y)) {
+            end = i + 1;
+            dirtyCount++;
+            gap = 0;
+          } else {
+            gap++;
+          }
+        }
+
+        uint8_t length = end - start;
+
+        // Each cell left to the scattered pass costs 3 bytes in a CharAtPos batch
+        if (OSD_COST_STRING_BASE + length < 3 * dirtyCount) {
+          if (_protocol != NULL) {
+            _protocol->displayWriteHorizontalString(start, y, &_cells[y * _columns + start], length);
+          }
+
+          _stats.horizontalStrings++;
+          _stats.bytes += OSD_COST_STRING_BASE + length;
+
+          for (uint8_t i = start; i < end; i++) {
+            cover(i, y);
+          }
+        }
+
+        x = end;
+      }
+    }
+  }
+
+  void OsdPlanner::planVerticalRuns() {
+    uint8_t string[OSD_MAX_VERTICAL_LENGTH];
+
+    for (uint8_t x = _x0; x < _x1; x++) {
+      uint8_t y = _y0;
+
+      while (y < _y1) {
+        if (!needsSending(x, y)) {
+          y++;
+          continue;
+        }
+
+        uint8_t start = y;
+        uint8_t end = y + 1;
+        uint8_t dirtyCount = 1;
+        uint8_t gap = 0;
+        for (uint8_t i = end; i < _y1 && i - start < OSD_MAX_VERTICAL_LENGTH && gap < OSD_COST_STRING_BASE; i++) {
+          if (needsSending(x, i)) {
+            end = i + 1;
+            dirtyCount++;
+            gap = 0;
+          } else {
+            gap++;
+          }
+        }
+
+        uint8_t length = end - start;
+
+        if (OSD_COST_STRING_BASE + length < 3 * dirtyCount) {
+          for (uint8_t i = 0; i < length; i++) {
+            string[i] = _cells[(start + i) * _columns + x];
+            cover(x, start + i);
+          }
+
+          if (_protocol != NULL) {
+            _protocol->displayWriteVerticalString(x, start, string, length);
+          }
+
+          _stats.verticalStrings++;
+          _stats.bytes += OSD_COST_STRING_BASE + length;
+        }
+
+        y = end;
+      }
+    }
+  }
+
+  void OsdPlanner::planScattered() {
+    size_t count = 0;
+    for (uint8_t y = _y0; y < _y1; y++) {
+      for (uint8_t x = _x0; x < _x1; x++) {
+        if (needsSending(x, y)) {
+          count++;
+        }
+      }
+    }
+
+    for (uint8_t y = _y0; y < _y1; y++) {
+      for (uint8_t x = _x0; x < _x1; x++) {
+        if (!needsSending(x, y)) {
+          continue;
+        }
+
+        // A batch of one costs more than a plain write char
+        if (_batchLength == 0 && count == 1) {
+          if (_protocol != NULL) {
+            _protocol->displayWriteChar(x, y, _cells[y * _columns + x]);
+          }
+
+          _stats.chars++;
+          _stats.bytes += OSD_COST_WRITE_CHAR;
+        } else {
+          addToBatch(x, y);
+        }
+
+        cover(x, y);
+        count--;
+      }
+    }
+
+    flushBatch();
+  }
+
+  void OsdPlanner::addToBatch(uint8_t x, uint8_t y) {
+    _batch[_batchLength].x = x;
+    _batch[_batchLength].y = y;
+    _batch[_batchLength].c = _cells[y * _columns + x];
+    _batchLength++;
+
+    if (_batchLength == OSD_MAX_CHAR_AT_POS) {
+      flushBatch();
+    }
+  }
+
+  void OsdPlanner::flushBatch() {
+    if (_batchLength == 0) {
+      return;
+    }
+
+    if (_protocol != NULL) {
+      _protocol->displayWriteString(0, 0, _batchLength, _batch);
+    }
+
+    _stats.charAtPosBatches++;
+    _stats.bytes += OSD_COST_CHAR_AT_POS_BASE + 3 * _batchLength;
+    _batchLength = 0;
+  }
+
+}
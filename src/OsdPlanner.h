@@ -0,0 +1,98 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OSD_PLANNER_H__
+#define __OSD_PLANNER_H__
+
+#include <Arduino.h>
+#include "RunCam_Protocol.h"
+
+// Bytes on the wire for each display command, including header, command id and crc
+#define OSD_COST_FILL_REGION 8
+#define OSD_COST_WRITE_CHAR 6
+#define OSD_COST_STRING_BASE 6          // Plus one byte per character
+#define OSD_COST_CHAR_AT_POS_BASE 4     // Plus three bytes per character
+
+#define OSD_MAX_HORIZONTAL_LENGTH 60
+#define OSD_MAX_VERTICAL_LENGTH 59
+#define OSD_MAX_CHAR_AT_POS 20
+
+namespace RunCam {
+
+  struct OsdPlanStats {
+    size_t bytes;
+    uint16_t fills;
+    uint16_t chars;
+    uint16_t horizontalStrings;
+    uint16_t verticalStrings;
+    uint16_t charAtPosBatches;
+  };
+
+  // Chooses the mix of display commands that sends a set of changed cells in the fewest bytes.
+  //
+  // Cells are considered in order of how much each encoding saves:
+  //  1. Rectangles of a single character become a fill when that is cheaper than strings for the same cells.
+  //  2. Runs along a row become a horizontal string when cheaper than sending the cells scattered.
+  //  3. Runs down a column become a vertical string on the same basis.
+  //  4. Whatever is left is packed into CharAtPos batches, or a single write char for a lone cell.
+  class OsdPlanner {
+    public:
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+      OsdPlanner(uint8_t columns, uint8_t rows);
+#endif
+      // Uses the caller's columns * rows bytes of scratch instead of allocating it
+      OsdPlanner(uint8_t columns, uint8_t rows, uint8_t *covered);
+      ~OsdPlanner();
+
+      // Plan and send the cells where cells differs from sent, limited to the given region.  Pass a NULL
+      // protocol to only work out the cost.  Returns the number of bytes sent (or that would be sent).
+      size_t plan(const uint8_t *cells, const uint8_t *sent, Protocol *protocol);
+      size_t plan(const uint8_t *cells, const uint8_t *sent, uint8_t x, uint8_t y, uint8_t width, uint8_t height, Protocol *protocol);
+
+      OsdPlanStats getStats();
+
+    private:
+      uint8_t _columns;
+      uint8_t _rows;
+      uint8_t *_covered;
+      bool _ownsCovered;
+      const uint8_t *_cells;
+      const uint8_t *_sent;
+      uint8_t _x0;
+      uint8_t _y0;
+      uint8_t _x1;
+      uint8_t _y1;
+      Protocol *_protocol;
+      OsdPlanStats _stats;
+      CharAtPos _batch[OSD_MAX_CHAR_AT_POS];
+      uint8_t _batchLength;
+
+      bool needsSending(uint8_t x, uint8_t y);
+      void cover(uint8_t x, uint8_t y);
+
+      void planFills();
+      bool tryFill(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t c);
+      void planHorizontalRuns();
+      void planVerticalRuns();
+      void planScattered();
+
+      void addToBatch(uint8_t x, uint8_t y);
+      void flushBatch();
+  };
+
+}
+
+#endif // __OSD_PLANNER_H__
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "OsdScheduler.h"
+
+namespace RunCam {
+
+  OsdScheduler::OsdScheduler(OsdFrameBuffer *osd, Protocol *protocol, uint32_t bytesPerSecond) {
+    _osd = osd;
+    _protocol = protocol;
+    _elementCount = 0;
+    _budget = bytesPerSecond != OSD_DEFAULT_BUDGET ? bytesPerSecond : protocol->getThroughput();
+    _tokens = getBurst();
+    _credit = 0;
+    _lastTick = millis();
+    _bytesSent = 0;
+  }
+
+  int OsdScheduler::addElement(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t priority, uint16_t refreshInterval) {
+    if (_elementCount == OSD_SCHEDULER_MAX_ELEMENTS) {
+      return -1;
+    }
+
+    OsdElement *element = &_elements[_elementCount];
+    element->x = x;
+    element->y = y;
+    element->width = width;
+    element->height = height;
+    element->priority = priority;
+    element->refreshInterval = refreshInterval;
+    element->lastSent = millis() - refreshInterval;
+    element->deferred = 0;
+
+    return _elementCount++;
+  }
+
+  void OsdScheduler::setBudget(uint32_t bytesPerSecond) {
+    _budget = bytesPerSecond;
+
+    if (_tokens > getBurst()) {
+      _tokens = getBurst();
+    }
+  }
+
+  uint32_t OsdScheduler::getBudget() {
+    return _budget;
+  }
+
+  // Always allow at least one maximum size frame through
+  int32_t OsdScheduler::getBurst() {
+    int32_t burst = _budget * OSD_BURST_MS / 1000;
+
+    return burst < COMMAND_BUFF_SIZE ? COMMAND_BUFF_SIZE : burst;
+  }
+
+  const OsdElement *OsdScheduler::getElement(int index) {
+    if (index < 0 || index >= _elementCount) {
+      return NULL;
+    }
+
+    return &_elements[index];
+  }
+
+  size_t OsdScheduler::getBytesSent() {
+    return _bytesSent;
+  }
+
+  size_t OsdScheduler::tick() {
+    unsigned long now = millis();
+
+    // Top up the budget for the time since the last tick.  Credit worth less than a byte is kept for the
+    // next tick, so ticking faster than the budget earns whole bytes still adds up.
+    unsigned long elapsed = now - _lastTick;
+    int32_t burst = getBurst();
+    _lastTick = now;
+
+    if (_tokens < burst && _budget > 0) {
+      // Any longer than it takes to fill the budget doesn't matter, and multiplying it could overflow
+      uint32_t fillTime = ((uint32_t)(burst - _tokens) * 1000 - _credit) / _budget + 1;
+
+      if (elapsed >= fillTime) {
+        _tokens = burst;
+      } else {
+        _credit += elapsed * _budget;
+        _tokens += _credit / 1000;
+        _credit %= 1000;
+      }
+    }
+    if (_tokens >= burst) {
+      _tokens = burst;
+      _credit = 0;
+    }
+
+    // Due elements ordered by priority, then by how long they have waited
+    uint8_t due[OSD_SCHEDULER_MAX_ELEMENTS];
+    uint8_t dueCount = 0;
+
+    for (uint8_t i = 0; i < _elementCount; i++) {
+      OsdElement *element = &_elements[i];
+
+      if (now - element->lastSent < element->refreshInterval) {
+        continue;
+      }
+
+      uint8_t j = dueCount++;
+      while (j > 0) {
+        OsdElement *other = &_elements[due[j - 1]];
+
+        if (other->priority > element->priority || (other->priority == element->priority && other->lastSent <= element->lastSent)) {
+          break;
+        }
+
+        due[j] = due[j - 1];
+        j--;
+      }
+      due[j] = i;
+    }
+
+    size_t bytesSent = 0;
+
+    for (uint8_t i = 0; i < dueCount; i++) {
+      OsdElement *element = &_elements[due[i]];
+
+      size_t cost = _osd->getCommitCost(element->x, element->y, element->width, element->height);
+      if (cost == 0) {
+        continue;
+      }
+
+      // An element bigger than the burst size goes once the budget is full and is paid back afterwards
+      if ((int32_t)cost > _tokens && _tokens < getBurst()) {
+        // Hold the budget back for this element rather than letting lower priority ones use it
+        element->deferred++;
+        break;
+      }
+
+      size_t sent = _osd->commit(_protocol, element->x, element->y, element->width, element->height);
+
+      _tokens -= sent;
+      bytesSent += sent;
+      element->lastSent = now;
+    }
+
+    _bytesSent += bytesSent;
+
+    return bytesSent;
+  }
+
+}
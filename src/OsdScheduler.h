@@ -0,0 +1,86 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __OSD_SCHEDULER_H__
+#define __OSD_SCHEDULER_H__
+
+#include <Arduino.h>
+#include "RunCam_Protocol.h"
+#include "OsdFrameBuffer.h"
+
+#ifndef OSD_SCHEDULER_MAX_ELEMENTS
+#define OSD_SCHEDULER_MAX_ELEMENTS 16
+#endif
+
+#define OSD_DEFAULT_BUDGET 0            // Use the full throughput of the protocol's link
+#define OSD_BURST_MS 100                // How much unused budget can be saved up
+
+#define OSD_PRIORITY_LOW 0
+#define OSD_PRIORITY_NORMAL 128
+#define OSD_PRIORITY_HIGH 255
+
+namespace RunCam {
+
+  struct OsdElement {
+    uint8_t x;
+    uint8_t y;
+    uint8_t width;
+    uint8_t height;
+    uint8_t priority;
+    uint16_t refreshInterval;   // Minimum milliseconds between updates
+    unsigned long lastSent;
+    uint16_t deferred;          // Ticks the element was due and changed but didn't fit in the budget
+  };
+
+  // Sends the changed regions of an OsdFrameBuffer within a bytes per second budget.  The screen is split
+  // into elements, each with a priority and refresh interval.  On each tick the due elements that have
+  // changed are sent in priority order while the budget allows.  If the highest priority element doesn't
+  // fit nothing lower is sent either, so fast changing elements never wait behind static ones.
+  //
+  // Only cells inside an element are sent.
+  class OsdScheduler {
+    public:
+      OsdScheduler(OsdFrameBuffer *osd, Protocol *protocol, uint32_t bytesPerSecond = OSD_DEFAULT_BUDGET);
+
+      // Returns the element index, or -1 if there is no room for more elements
+      int addElement(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t priority, uint16_t refreshInterval);
+
+      void setBudget(uint32_t bytesPerSecond);
+      uint32_t getBudget();
+
+      // Call from loop().  Returns the number of bytes sent.
+      size_t tick();
+
+      const OsdElement *getElement(int index);
+      size_t getBytesSent();
+
+    private:
+      OsdFrameBuffer *_osd;
+      Protocol *_protocol;
+      OsdElement _elements[OSD_SCHEDULER_MAX_ELEMENTS];
+      uint8_t _elementCount;
+      uint32_t _budget;
+      int32_t _tokens;
+      uint32_t _credit;           // Thousandths of a byte not yet added to the tokens
+      unsigned long _lastTick;
+      size_t _bytesSent;
+
+      int32_t getBurst();
+  };
+
+}
+
+#endif // __OSD_SCHEDULER_H__
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ProtocolChannel.h"
+
+#ifdef RUNCAM_HAS_ATOMIC
+
+namespace RunCam {
+
+  ProtocolChannel::ProtocolChannel() {
+    _nextId = 1;
+    _outstanding = 0;
+  }
+
+  uint32_t ProtocolChannel::request(uint8_t command, const uint8_t *args, uint8_t count, const char *text) {
+    // Never more requests out than there is room for their results, so the I/O thread can always post them
+    if (_outstanding == PROTOCOL_CHANNEL_SIZE) {
+      return 0;
+    }
+
+    ChannelRequest *request = _requests.reserve();
+    if (request == NULL) {
+      return 0;
+    }
+
+    // Id 0 means the request could not be made
+    if (_nextId == 0) {
+      _nextId = 1;
+    }
+
+    request->id = _nextId++;
+    request->command = command;
+    if (count > 0) {
+      memcpy(request->args, args, count);
+    }
+    request->length = 0;
+    if (text != NULL) {
+      size_t length = strlen(text);
+      request->length = length < PROTOCOL_CHANNEL_MAX_TEXT ? length : PROTOCOL_CHANNEL_MAX_TEXT;
+      memcpy(request->text, text, request->length);
+    }
+    request->text[request->length] = '\0';
+
+    _requests.commit();
+    _outstanding++;
+
+    return request->id;
+  }
+
+  uint32_t ProtocolChannel::readCameraInfo() {
+    return request(COMMAND_READ_CAMERA_INFO, NULL, 0, NULL);
+  }
+
+  uint32_t ProtocolChannel::cameraControl(uint8_t actionId) {
+    return request(COMMAND_CAMERA_CONTROL, &actionId, 1, NULL);
+  }
+
+  uint32_t ProtocolChannel::fiveKeySimulationPress(uint8_t actionId) {
+    return request(COMMAND_FIVE_KEY_SIMULATION_PRESS, &actionId, 1, NULL);
+  }
+
+  uint32_t ProtocolChannel::fiveKeySimulationRelease() {
+    return request(COMMAND_FIVE_KEY_SIMULATION_RELEASE, NULL, 0, NULL);
+  }
+
+  uint32_t ProtocolChannel::fiveKeySimulationConnection(uint8_t actionId) {
+    return request(COMMAND_FIVE_KEY_SIMULATION_CONNECTION, &actionId, 1, NULL);
+  }
+
+  uint32_t ProtocolChannel::writeSetting(uint8_t settingId, uint8_t value) {
+    uint8_t args[] = { settingId, value };
+    return request(COMMAND_WRITE_SETTING, args, sizeof(args), NULL);
+  }
+
+  uint32_t ProtocolChannel::writeSetting(uint8_t settingId, const char *value) {
+    return request(COMMAND_WRITE_SETTING, &settingId, 1, value != NULL ? value : "");
+  }
+
+  uint32_t ProtocolChannel::displayFillRegion(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character) {
+    uint8_t args[] = { x, y, width, height, character };
+    return request(COMMAND_DISPLAY_FILL_REGION, args, sizeof(args), NULL);
+  }
+
+  uint32_t ProtocolChannel::displayWriteChar(uint8_t x, uint8_t y, uint8_t character) {
+    uint8_t args[] = { x, y, character };
+    return request(COMMAND_DISPLAY_WRITE_CHAR, args, sizeof(args), NULL);
+  }
+
+  uint32_t ProtocolChannel::displayWriteHorizontalString(uint8_t x, uint8_t y, const char *string) {
+    uint8_t args[] = { x, y };
+    return request(COMMAND_DISPLAY_WRITE_HORIZONTAL_STRING, args, sizeof(args), string != NULL ? string : "");
+  }
+
+  uint32_t ProtocolChannel::displayWriteVerticalString(uint8_t x, uint8_t y, const char *string) {
+    uint8_t args[] = { x, y };
+    return request(COMMAND_DISPLAY_WRITE_VERTICAL_STRING, args, sizeof(args), string != NULL ? string : "");
+  }
+
+  uint8_t ProtocolChannel::getOutstandingCount() {
+    return _outstanding;
+  }
+
+  bool ProtocolChannel::getResult(ChannelResult *result) {
+    ChannelResult *next = _results.front();
+    if (next == NULL) {
+      return false;
+    }
+
+    *result = *next;
+    _results.pop();
+    _outstanding--;
+
+    return true;
+  }
+
+  bool ProtocolChannel::waitForResult(ChannelResult *result, unsigned long timeout) {
+    unsigned long start = millis();
+    while (!getResult(result)) {
+      if (millis() - start >= timeout) {
+        return false;
+      }
+
+      yield();
+    }
+
+    return true;
+  }
+
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PROTOCOL_CHANNEL_H__
+#define __PROTOCOL_CHANNEL_H__
+
+#include "RunCam_Protocol.h"
+#include "SpscRing.h"
+
+#ifdef RUNCAM_HAS_ATOMIC
+
+#ifndef PROTOCOL_CHANNEL_SIZE
+#define PROTOCOL_CHANNEL_SIZE 8                 // Requests a channel can have outstanding, a power of 2
+#endif
+
+#define PROTOCOL_CHANNEL_MAX_TEXT 60            // The most a display or setting string request carries
+
+namespace RunCam {
+
+  // A command for the I/O thread, with the arguments of the Protocol submit call it becomes
+  struct ChannelRequest {
+    uint32_t id;
+    uint8_t command;
+    uint8_t args[5];
+    uint8_t length;                             // Of text, 0 when the command takes an integer value
+    char text[PROTOCOL_CHANNEL_MAX_TEXT + 1];
+  };
+
+  struct ChannelResult {
+    uint32_t id;                                // As returned when the request was made
+    CommandResult result;
+  };
+
+  // One application thread's connection to a ProtocolWorker.  Requests go to the I/O thread and results
+  // come back through a pair of single producer, single consumer rings, so neither side ever blocks the
+  // other.  Each thread that talks to the camera needs its own channel.
+  //
+  // A request returns its id, or 0 if PROTOCOL_CHANNEL_SIZE requests are already waiting for results.
+  // Results arrive in the order the requests were made.
+  class ProtocolChannel {
+    public:
+      ProtocolChannel();
+
+      uint32_t readCameraInfo();
+      uint32_t cameraControl(uint8_t actionId);
+      uint32_t fiveKeySimulationPress(uint8_t actionId);
+      uint32_t fiveKeySimulationRelease();
+      uint32_t fiveKeySimulationConnection(uint8_t actionId);
+      uint32_t writeSetting(uint8_t settingId, uint8_t value);
+      uint32_t writeSetting(uint8_t settingId, const char *value);
+      uint32_t displayFillRegion(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character);
+      uint32_t displayWriteChar(uint8_t x, uint8_t y, uint8_t character);
+      uint32_t displayWriteHorizontalString(uint8_t x, uint8_t y, const char *string);
+      uint32_t displayWriteVerticalString(uint8_t x, uint8_t y, const char *string);
+
+      // Requests made and not yet collected with getResult()
+      uint8_t getOutstandingCount();
+
+      // Takes the next result without waiting, false if there is none yet
+      bool getResult(ChannelResult *result);
+
+      // Waits up to timeout milliseconds for the next result
+      bool waitForResult(ChannelResult *result, unsigned long timeout);
+
+    private:
+      friend class ProtocolWorker;
+
+      SpscRing<ChannelRequest, PROTOCOL_CHANNEL_SIZE> _requests;    // Application to I/O thread
+      SpscRing<ChannelResult, PROTOCOL_CHANNEL_SIZE> _results;      // I/O thread to application
+
+      // Only touched by the application thread
+      uint32_t _nextId;
+      uint8_t _outstanding;
+
+      uint32_t request(uint8_t command, const uint8_t *args, uint8_t count, const char *text);
+  };
+
+}
+
+#endif
+
+#endif // __PROTOCOL_CHANNEL_H__
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ProtocolStats.h"
+#include "RunCam_Protocol.h"
+
+namespace RunCam {
+
+  void resetStats(ProtocolStats *stats) {
+    memset(stats, 0, sizeof(ProtocolStats));
+
+    for (uint8_t i = 0; i < PROTOCOL_STATS_COMMANDS; i++) {
+      stats->commands[i].command = Protocol::RESPONSE_COMMANDS[i];
+      stats->commands[i].minLatency = 0xffffffff;
+    }
+  }
+
+  CommandStats *getCommandStats(ProtocolStats *stats, uint8_t command) {
+    int8_t index = Protocol::getResponseCommandIndex(command);
+    if (index < 0) {
+      return NULL;
+    }
+
+    return &stats->commands[index];
+  }
+
+  uint8_t getLatencyBucket(uint32_t latency) {
+    uint8_t bucket = 0;
+    uint32_t limit = PROTOCOL_STATS_FIRST_BUCKET_US;
+
+    while (latency >= limit && bucket < PROTOCOL_STATS_BUCKETS - 1) {
+      limit <<= 1;
+      bucket++;
+    }
+
+    return bucket;
+  }
+
+  uint32_t getLatencyBucketLimit(uint8_t bucket) {
+    if (bucket >= PROTOCOL_STATS_BUCKETS - 1) {
+      return 0xffffffff;
+    }
+
+    return (uint32_t)PROTOCOL_STATS_FIRST_BUCKET_US << bucket;
+  }
+
+  uint32_t getLatencyPercentile(const CommandStats *stats, uint8_t percent) {
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < PROTOCOL_STATS_BUCKETS; i++) {
+      total += stats->histogram[i];
+    }
+
+    if (total == 0) {
+      return 0;
+    }
+
+    // Rounded up so the 100th percentile includes every response
+    uint32_t target = (total * percent + 99) / 100;
+    uint32_t count = 0;
+
+    uint8_t bucket = 0;
+    while (bucket < PROTOCOL_STATS_BUCKETS - 1) {
+      count += stats->histogram[bucket];
+      if (count >= target) {
+        break;
+      }
+      bucket++;
+    }
+
+    // Nothing took longer than the slowest response
+    uint32_t limit = getLatencyBucketLimit(bucket);
+    return limit < stats->maxLatency ? limit : stats->maxLatency;
+  }
+}
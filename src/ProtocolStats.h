@@ -0,0 +1,75 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PROTOCOL_STATS_H__
+#define __PROTOCOL_STATS_H__
+
+#include <Arduino.h>
+#include "CommandQueue.h"
+
+// Protocol keeps these unless RUNCAM_NO_STATS is defined, in which case none of the counting is compiled in
+
+#define PROTOCOL_STATS_COMMANDS RESPONSE_COMMAND_COUNT
+#define PROTOCOL_STATS_BUCKETS 12
+#define PROTOCOL_STATS_FIRST_BUCKET_US 256    // Each bucket covers twice the latency of the one before
+
+namespace RunCam {
+
+  struct CommandStats {
+    uint8_t command;
+    uint32_t requests;
+    uint32_t responses;                       // Complete with a good crc
+    uint32_t timeouts;
+    uint32_t errors;                          // Bad header, length or crc
+    uint32_t retries;                         // Sent again straight after failing
+
+    // Round trip from sending the request to the last byte of a complete response, in microseconds
+    uint32_t totalLatency;
+    uint32_t minLatency;
+    uint32_t maxLatency;
+    uint16_t histogram[PROTOCOL_STATS_BUCKETS];
+  };
+
+  struct ProtocolStats {
+    uint32_t requests;                        // Every command, including those without a response
+    uint32_t bytesSent;
+    uint32_t bytesReceived;
+    uint32_t bytesDiscarded;                  // Received while not waiting for a response
+    uint32_t bytesSkipped;                    // Received while waiting but not part of the response
+    uint32_t resyncs;                         // Corrupt frames dropped for a later header
+    uint32_t timeouts;
+    uint32_t errors;
+    uint32_t retries;
+    CommandStats commands[PROTOCOL_STATS_COMMANDS];
+  };
+
+  void resetStats(ProtocolStats *stats);
+
+  // NULL for commands without a response
+  CommandStats *getCommandStats(ProtocolStats *stats, uint8_t command);
+
+  // Latencies below the limit of a bucket and at or above the limit of the one before fall into it.  The
+  // last bucket has no limit.
+  uint8_t getLatencyBucket(uint32_t latency);
+  uint32_t getLatencyBucketLimit(uint8_t bucket);
+
+  // The bucket limit that percent of the responses were faster than, capped at the slowest response.  0 if
+  // there have been none.
+  uint32_t getLatencyPercentile(const CommandStats *stats, uint8_t percent);
+
+}
+
+#endif // __PROTOCOL_STATS_H__
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ProtocolTrace.h"
+#include "ResponseParser.h"
+
+namespace RunCam {
+
+  ProtocolTrace::ProtocolTrace() {
+    _stopOnError = false;
+    clear();
+  }
+
+  void ProtocolTrace::clear() {
+    _head = 0;
+    _count = 0;
+    _overwritten = 0;
+    _stopped = false;
+  }
+
+  void ProtocolTrace::record(uint8_t type, uint8_t data) {
+    if (_stopped) {
+      return;
+    }
+
+    uint16_t index = (_head + _count) % PROTOCOL_TRACE_SIZE;
+    if (_count == PROTOCOL_TRACE_SIZE) {
+      _head = (_head + 1) % PROTOCOL_TRACE_SIZE;
+      _overwritten++;
+    } else {
+      _count++;
+    }
+
+    _events[index].time = micros();
+    _events[index].type = type;
+    _events[index].data = data;
+
+    if (_stopOnError && type == TRACE_EVENT_RESULT && data != RESPONSE_PARSER_COMPLETE) {
+      _stopped = true;
+    }
+  }
+
+  void ProtocolTrace::record(uint8_t type, const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+      record(type, data[i]);
+    }
+  }
+
+  void ProtocolTrace::setStopOnError(bool stopOnError) {
+    _stopOnError = stopOnError;
+  }
+
+  bool ProtocolTrace::isStopped() {
+    return _stopped;
+  }
+
+  uint16_t ProtocolTrace::getCount() {
+    return _count;
+  }
+
+  // Oldest first
+  const TraceEvent *ProtocolTrace::get(uint16_t index) {
+    if (index >= _count) {
+      return NULL;
+    }
+
+    return &_events[(_head + index) % PROTOCOL_TRACE_SIZE];
+  }
+
+  uint32_t ProtocolTrace::getOverwrittenCount() {
+    return _overwritten;
+  }
+
+  size_t ProtocolTrace::encodeHeader(uint8_t *buf) {
+    unsigned long start = _count > 0 ? get(0)->time : 0;
+
+    buf[0] = 'R';
+    buf[1] = 'C';
+    buf[2] = 'T';
+    buf[3] = TRACE_FORMAT_VERSION;
+    buf[4] = _count & 0xff;
+    buf[5] = _count >> 8;
+    buf[6] = start & 0xff;
+    buf[7] = (start >> 8) & 0xff;
+    buf[8] = (start >> 16) & 0xff;
+    buf[9] = (start >> 24) & 0xff;
+
+    return TRACE_HEADER_SIZE;
+  }
+
+  size_t ProtocolTrace::encodeEvent(uint8_t *buf, uint16_t index) {
+    const TraceEvent *event = get(index);
+    unsigned long delta = index > 0 ? event->time - get(index - 1)->time : 0;
+
+    size_t p = 0;
+    buf[p++] = event->type;
+    buf[p++] = event->data;
+
+    // Bytes at 115200 baud are under 100us apart so the delta is usually one or two bytes
+    while (delta >= 0x80) {
+      buf[p++] = (delta & 0x7f) | 0x80;
+      delta >>= 7;
+    }
+    buf[p++] = delta;
+
+    return p;
+  }
+
+  size_t ProtocolTrace::getEncodedSize() {
+    uint8_t buf[TRACE_MAX_EVENT_SIZE];
+    size_t size = TRACE_HEADER_SIZE;
+
+    for (uint16_t i = 0; i < _count; i++) {
+      size += encodeEvent(buf, i);
+    }
+
+    return size;
+  }
+
+  size_t ProtocolTrace::encode(uint8_t *buf, size_t size) {
+    if (size < getEncodedSize()) {
+      return 0;
+    }
+
+    size_t p = encodeHeader(buf);
+    for (uint16_t i = 0; i < _count; i++) {
+      p += encodeEvent(buf + p, i);
+    }
+
+    return p;
+  }
+
+  size_t ProtocolTrace::write(Print *out) {
+    uint8_t buf[TRACE_HEADER_SIZE];
+
+    size_t written = out->write(buf, encodeHeader(buf));
+    for (uint16_t i = 0; i < _count; i++) {
+      written += out->write(buf, encodeEvent(buf, i));
+    }
+
+    return written;
+  }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PROTOCOL_TRACE_H__
+#define __PROTOCOL_TRACE_H__
+
+#include <Arduino.h>
+
+#ifndef PROTOCOL_TRACE_SIZE
+#define PROTOCOL_TRACE_SIZE 256               // Events kept, the oldest are overwritten
+#endif
+
+#define TRACE_EVENT_TX        0               // Byte sent to the camera
+#define TRACE_EVENT_RX        1               // Byte received from the camera
+#define TRACE_EVENT_EXPECT    2               // Waiting for a response, data is its length or RESPONSE_LENGTH_CHUNKED
+#define TRACE_EVENT_TIMEOUT   3               // Gave up waiting for the response
+#define TRACE_EVENT_RESULT    4               // The response finished, data is the parser state
+
+// Trace format, all values little endian:
+//   header: 'R' 'C' 'T' [version] [event count:16] [time of first event in us:32]
+//   events: [type] [data] [us since the previous event, 7 bits per byte with the top bit set on all but the last]
+#define TRACE_FORMAT_VERSION 1
+#define TRACE_HEADER_SIZE 10
+#define TRACE_MAX_EVENT_SIZE 7
+
+namespace RunCam {
+
+  struct TraceEvent {
+    unsigned long time;                       // micros()
+    uint8_t type;
+    uint8_t data;
+  };
+
+  // Records the bytes going over the link in a fixed ring buffer so what led up to a failure can be dumped
+  // and replayed later with a TraceReplayer.  Attach it with Protocol::setTrace().
+  class ProtocolTrace {
+    public:
+      ProtocolTrace();
+
+      void record(uint8_t type, uint8_t data);
+      void record(uint8_t type, const uint8_t *data, size_t length);
+      void clear();
+
+      // Stop recording after the first corrupt or missing response so it isn't overwritten before the
+      // trace is dumped.  clear() starts recording again.
+      void setStopOnError(bool stopOnError);
+      bool isStopped();
+
+      uint16_t getCount();
+      const TraceEvent *get(uint16_t index);
+      uint32_t getOverwrittenCount();
+
+      // The trace in the binary format.  encode() returns 0 if the buffer is too small.
+      size_t getEncodedSize();
+      size_t encode(uint8_t *buf, size_t size);
+      size_t write(Print *out);
+
+    private:
+      TraceEvent _events[PROTOCOL_TRACE_SIZE];
+      uint16_t _head;
+      uint16_t _count;
+      uint32_t _overwritten;
+      bool _stopOnError;
+      bool _stopped;
+
+      size_t encodeHeader(uint8_t *buf);
+      size_t encodeEvent(uint8_t *buf, uint16_t index);
+  };
+
+}
+
+#endif // __PROTOCOL_TRACE_H__
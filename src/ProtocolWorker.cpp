@@ -0,0 +1,181 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ProtocolWorker.h"
+
+#ifdef RUNCAM_HAS_ATOMIC
+
+namespace RunCam {
+
+  ProtocolWorker::ProtocolWorker(Protocol *protocol) {
+    _protocol = protocol;
+    _channelCount = 0;
+    _nextChannel = 0;
+
+    for (uint8_t i = 0; i < COMMAND_QUEUE_SIZE; i++) {
+      _pending[i].worker = this;
+      _pending[i].channel = NULL;
+      _pending[i].id = 0;
+    }
+  }
+
+  bool ProtocolWorker::attach(ProtocolChannel *channel) {
+    if (channel == NULL || _channelCount == PROTOCOL_WORKER_MAX_CHANNELS) {
+      return false;
+    }
+
+    _channels[_channelCount++] = channel;
+    return true;
+  }
+
+  Protocol *ProtocolWorker::getProtocol() {
+    return _protocol;
+  }
+
+  // Only ever one result per request, and the channel stops making requests once that many are waiting
+  // to be collected, so there is always a free slot
+  void ProtocolWorker::post(ProtocolChannel *channel, uint32_t id, const CommandResult &result) {
+    ChannelResult *slot = channel->_results.reserve();
+    if (slot == NULL) {
+      return;
+    }
+
+    slot->id = id;
+    slot->result = result;
+    channel->_results.commit();
+  }
+
+  void ProtocolWorker::requestDone(const CommandResult &result, void *context) {
+    PendingRequest *pending = (PendingRequest *)context;
+
+    post(pending->channel, pending->id, result);
+    pending->channel = NULL;
+  }
+
+  ProtocolWorker::PendingRequest *ProtocolWorker::reservePending() {
+    for (uint8_t i = 0; i < COMMAND_QUEUE_SIZE; i++) {
+      if (_pending[i].channel == NULL) {
+        return &_pending[i];
+      }
+    }
+
+    return NULL;
+  }
+
+  bool ProtocolWorker::submit(ChannelRequest *request, PendingRequest *pending) {
+    const uint8_t *args = request->args;
+
+    switch (request->command) {
+      case COMMAND_READ_CAMERA_INFO:
+        return _protocol->submitReadCameraInfo(requestDone, pending) != 0;
+
+      case COMMAND_CAMERA_CONTROL:
+        return _protocol->submitCameraControl(args[0], requestDone, pending) != 0;
+
+      case COMMAND_FIVE_KEY_SIMULATION_PRESS:
+        return _protocol->submitFiveKeySimulationPress(args[0], requestDone, pending) != 0;
+
+      case COMMAND_FIVE_KEY_SIMULATION_RELEASE:
+        return _protocol->submitFiveKeySimulationRelease(requestDone, pending) != 0;
+
+      case COMMAND_FIVE_KEY_SIMULATION_CONNECTION:
+        return _protocol->submitFiveKeySimulationConnection(args[0], requestDone, pending) != 0;
+
+      case COMMAND_WRITE_SETTING:
+        if (request->length > 0) {
+          return _protocol->submitWriteSetting(args[0], String(request->text), requestDone, pending) != 0;
+        }
+        return _protocol->submitWriteSetting(args[0], args[1], requestDone, pending) != 0;
+
+      case COMMAND_DISPLAY_FILL_REGION:
+        return _protocol->submitDisplayFillRegion(args[0], args[1], args[2], args[3], args[4], requestDone, pending) != 0;
+
+      case COMMAND_DISPLAY_WRITE_CHAR:
+        return _protocol->submitDisplayWriteChar(args[0], args[1], args[2], requestDone, pending) != 0;
+
+      case COMMAND_DISPLAY_WRITE_HORIZONTAL_STRING:
+        return _protocol->submitDisplayWriteHorizontalString(args[0], args[1], String(request->text), requestDone, pending) != 0;
+
+      case COMMAND_DISPLAY_WRITE_VERTICAL_STRING:
+        return _protocol->submitDisplayWriteVerticalString(args[0], args[1], String(request->text), requestDone, pending) != 0;
+    }
+
+    return false;
+  }
+
+  // One request from each channel in turn until the Protocol's queue is full or the channels are empty.
+  // Returns false if requests had to be left for later.
+  bool ProtocolWorker::takeRequests() {
+    bool taken = true;
+
+    while (taken) {
+      taken = false;
+
+      for (uint8_t i = 0; i < _channelCount; i++) {
+        ProtocolChannel *channel = _channels[(_nextChannel + i) % _channelCount];
+        ChannelRequest *request = channel->_requests.front();
+        if (request == NULL) {
+          continue;
+        }
+
+        PendingRequest *pending = reservePending();
+        if (pending == NULL || _protocol->getQueuedCommandCount() == COMMAND_QUEUE_SIZE) {
+          // Start with this channel next time so it isn't passed over
+          _nextChannel = (_nextChannel + i) % _channelCount;
+          return false;
+        }
+
+        pending->channel = channel;
+        pending->id = request->id;
+
+        if (!submit(request, pending)) {
+          // Could not be encoded, so fail it straight away
+          CommandResult result;
+          memset(&result, 0, sizeof(result));
+          result.command = request->command;
+          result.remainingChunks = -1;
+
+          post(channel, request->id, result);
+          pending->channel = NULL;
+        }
+
+        channel->_requests.pop();
+        taken = true;
+      }
+    }
+
+    if (_channelCount > 0) {
+      _nextChannel = (_nextChannel + 1) % _channelCount;
+    }
+
+    return true;
+  }
+
+  void ProtocolWorker::poll() {
+    takeRequests();
+    _protocol->poll();
+  }
+
+  void ProtocolWorker::run(const std::atomic<bool> *stop) {
+    while (!stop->load(std::memory_order_relaxed)) {
+      poll();
+      yield();
+    }
+  }
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __PROTOCOL_WORKER_H__
+#define __PROTOCOL_WORKER_H__
+
+#include "RunCam_Protocol.h"
+#include "ProtocolChannel.h"
+
+#ifdef RUNCAM_HAS_ATOMIC
+
+#ifndef PROTOCOL_WORKER_MAX_CHANNELS
+#define PROTOCOL_WORKER_MAX_CHANNELS 8
+#endif
+
+namespace RunCam {
+
+  // The thread safe front end to a Protocol.  The worker and its Protocol belong to one I/O thread, which
+  // is the only one to touch the UART and the Protocol's buffers.  Other threads talk to the camera through
+  // ProtocolChannels attached to the worker.
+  //
+  // poll() takes requests from the channels in turn, queues them on the Protocol and posts each result back
+  // to the channel it came from.  Nothing is locked, so a busy channel never holds up the I/O thread.
+  class ProtocolWorker {
+    public:
+      ProtocolWorker(Protocol *protocol);
+
+      // Before the I/O thread starts, or from it
+      bool attach(ProtocolChannel *channel);
+      Protocol *getProtocol();
+
+      // On the I/O thread only
+      void poll();
+      void run(const std::atomic<bool> *stop);
+
+    private:
+      struct PendingRequest {
+        ProtocolWorker *worker;
+        ProtocolChannel *channel;               // NULL when the slot is free
+        uint32_t id;
+      };
+
+      Protocol *_protocol;
+      ProtocolChannel *_channels[PROTOCOL_WORKER_MAX_CHANNELS];
+      uint8_t _channelCount;
+      uint8_t _nextChannel;                     // Where the next round of taking requests starts
+      PendingRequest _pending[COMMAND_QUEUE_SIZE];
+
+      bool takeRequests();
+      bool submit(ChannelRequest *request, PendingRequest *pending);
+      PendingRequest *reservePending();
+      static void post(ProtocolChannel *channel, uint32_t id, const CommandResult &result);
+      static void requestDone(const CommandResult &result, void *context);
+  };
+
+}
+
+#endif
+
+#endif // __PROTOCOL_WORKER_H__
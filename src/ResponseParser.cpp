@@ -0,0 +1,182 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ResponseParser.h"
+#include "Crc8.h"
+
+#define RESPONSE_HEADER 0xcc
+
+#define FRAME_OK          0
+#define FRAME_BAD_LENGTH  1     // Chunk count or data length out of range
+#define FRAME_BAD_CRC     2
+
+namespace RunCam {
+
+  ResponseParser::ResponseParser() {
+    reset();
+  }
+
+  void ResponseParser::expect(uint8_t length) {
+    start(length, false);
+  }
+
+  void ResponseParser::expectChunked(uint8_t maxDataLength) {
+    // Header, remaining chunks and data length are known up front, the rest once the length byte arrives
+    start(3, true);
+    _maxDataLength = maxDataLength < RESPONSE_MAX_CHUNK_DATA ? maxDataLength : RESPONSE_MAX_CHUNK_DATA;
+  }
+
+  void ResponseParser::reset() {
+    _state = RESPONSE_PARSER_IDLE;
+    _chunked = false;
+    _count = 0;
+    _checked = 0;
+    _expected = 0;
+    _initialExpected = 0;
+    _maxDataLength = RESPONSE_MAX_CHUNK_DATA;
+    _crc = 0;
+    _skipped = 0;
+    _resyncs = 0;
+  }
+
+  void ResponseParser::timeout() {
+    if (_state == RESPONSE_PARSER_PENDING) {
+      _state = RESPONSE_PARSER_TIMEOUT;
+    }
+  }
+
+  void ResponseParser::start(uint8_t expected, bool chunked) {
+    _state = expected <= RESPONSE_BUFF_SIZE ? RESPONSE_PARSER_PENDING : RESPONSE_PARSER_ERROR;
+    _chunked = chunked;
+    _count = 0;
+    _checked = 0;
+    _expected = expected;
+    _initialExpected = expected;
+    _maxDataLength = RESPONSE_MAX_CHUNK_DATA;
+    _crc = 0;
+    _skipped = 0;
+    _resyncs = 0;
+  }
+
+  uint8_t ResponseParser::feed(uint8_t data) {
+    if (_state != RESPONSE_PARSER_PENDING) {
+      return _state;
+    }
+
+    // Scan for the header
+    if (_count == 0 && data != RESPONSE_HEADER) {
+      _skipped++;
+      return _state;
+    }
+
+    _buf[_count++] = data;
+
+    uint8_t result;
+    while ((result = check()) != FRAME_OK) {
+      if (resync()) {
+        continue;
+      }
+
+      // A header followed by an impossible count or length was most likely a stray byte so keep scanning
+      // for the real response.  A whole frame with a bad crc was the response.
+      if (result == FRAME_BAD_CRC) {
+        _state = RESPONSE_PARSER_ERROR;
+      }
+      break;
+    }
+
+    return _state;
+  }
+
+  // Check the bytes received since the last call, stopping as soon as the frame is known to be corrupt
+  uint8_t ResponseParser::check() {
+    while (_checked < _count) {
+      uint8_t data = _buf[_checked++];
+      _crc = Crc8::update(_crc, data);
+
+      if (_chunked && _checked == 2 && data > RESPONSE_MAX_REMAINING_CHUNKS) {
+        return FRAME_BAD_LENGTH;
+      }
+
+      // The data length byte of a chunked response tells us how much payload and crc follows
+      if (_chunked && _checked == 3) {
+        if (data > _maxDataLength) {
+          return FRAME_BAD_LENGTH;
+        }
+
+        _expected = data + 4;
+      }
+
+      if (_checked == _expected) {
+        // Including the trailing crc byte in the running crc gives zero for a good frame
+        if (_crc != 0) {
+          return FRAME_BAD_CRC;
+        }
+
+        // Anything received after the frame isn't part of it
+        _skipped += _count - _checked;
+        _count = _checked;
+
+        _state = RESPONSE_PARSER_COMPLETE;
+        return FRAME_OK;
+      }
+    }
+
+    return FRAME_OK;
+  }
+
+  // Drop the corrupt frame and start again from the next header in what has already been received.
+  // Returns false if there isn't one, leaving the parser scanning for a header.
+  bool ResponseParser::resync() {
+    uint8_t next = 1;
+    while (next < _count && _buf[next] != RESPONSE_HEADER) {
+      next++;
+    }
+
+    _skipped += next;
+    _resyncs++;
+
+    _count -= next;
+    memmove(_buf, _buf + next, _count);
+
+    _checked = 0;
+    _expected = _initialExpected;
+    _crc = 0;
+
+    return _count > 0;
+  }
+
+  uint8_t ResponseParser::getState() {
+    return _state;
+  }
+
+  const uint8_t *ResponseParser::getFrame() {
+    return _buf;
+  }
+
+  uint8_t ResponseParser::getLength() {
+    return _count;
+  }
+
+  uint16_t ResponseParser::getSkippedCount() {
+    return _skipped;
+  }
+
+  uint16_t ResponseParser::getResyncCount() {
+    return _resyncs;
+  }
+
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __RESPONSE_PARSER_H__
+#define __RESPONSE_PARSER_H__
+
+#include <Arduino.h>
+
+#define RESPONSE_BUFF_SIZE 65
+
+#define RESPONSE_MAX_REMAINING_CHUNKS 32          // More than this in a chunked response means it is corrupt
+#define RESPONSE_MAX_CHUNK_DATA (RESPONSE_BUFF_SIZE - 4)
+
+#define RESPONSE_PARSER_IDLE      0   // Not expecting a response
+#define RESPONSE_PARSER_PENDING   1   // Waiting for more bytes
+#define RESPONSE_PARSER_COMPLETE  2   // A complete frame with a valid header and crc has been received
+#define RESPONSE_PARSER_ERROR     3   // The frame had a bad crc and there was no other header to resync on
+#define RESPONSE_PARSER_TIMEOUT   4   // No complete frame arrived in time
+
+namespace RunCam {
+
+  // Resumable parser for device responses.  Bytes are fed in one at a time as they become available
+  // and the parser tracks the header, length, payload and crc state between calls.
+  //
+  // Responses come in two shapes:
+  //  - fixed length: [header] [payload...] [crc]
+  //  - chunked:      [header] [remaining chunks] [data length] [payload...] [crc]
+  //
+  // Bytes before the header are skipped.  A frame is dropped as soon as it is clearly corrupt, either with
+  // an out of range chunk count or length or with a bad crc, and parsing starts again from the next header.
+  // The response only fails on a bad crc with no later header already received, so a stray byte costs a
+  // few bytes rather than the response timeout.
+  class ResponseParser {
+    public:
+      ResponseParser();
+
+      // Start waiting for a fixed length response.  The length includes the header and crc bytes.
+      void expect(uint8_t length);
+
+      // Start waiting for a chunked response whose payload length is given by the third byte.
+      void expectChunked(uint8_t maxDataLength = RESPONSE_MAX_CHUNK_DATA);
+
+      // Stop waiting for a response
+      void reset();
+
+      // Give up on a pending response.  The parser has no notion of time so the owner decides when.
+      void timeout();
+
+      // Feed the next received byte. Returns the parser state after consuming it.
+      uint8_t feed(uint8_t data);
+
+      uint8_t getState();
+      const uint8_t *getFrame();
+      uint8_t getLength();
+
+      // Bytes thrown away and frames restarted on a later header while parsing the current response
+      uint16_t getSkippedCount();
+      uint16_t getResyncCount();
+
+    private:
+      uint8_t _buf[RESPONSE_BUFF_SIZE];
+      uint8_t _state;
+      bool _chunked;
+      uint8_t _count;
+      uint8_t _checked;                 // Bytes at the start of the buffer already checked
+      uint8_t _expected;
+      uint8_t _initialExpected;
+      uint8_t _maxDataLength;
+      uint8_t _crc;
+      uint16_t _skipped;
+      uint16_t _resyncs;
+
+      void start(uint8_t expected, bool chunked);
+      uint8_t check();
+      bool resync();
+  };
+
+}
+
+#endif // __RESPONSE_PARSER_H__
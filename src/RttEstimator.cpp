@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RttEstimator.h"
+
+namespace RunCam {
+
+  RttEstimator::RttEstimator() {
+    _floor = RTT_TIMEOUT_FLOOR_US;
+    _ceiling = RTT_TIMEOUT_CEILING_US;
+    reset();
+  }
+
+  void RttEstimator::reset() {
+    _srtt = 0;
+    _rttvar = 0;
+    _samples = 0;
+    setTimeout(RTT_TIMEOUT_INITIAL_US);
+  }
+
+  void RttEstimator::setLimits(unsigned long floor, unsigned long ceiling) {
+    _floor = floor;
+    _ceiling = ceiling;
+
+    if (_samples == 0) {
+      setTimeout(_timeout);
+    } else {
+      setTimeout(_srtt + 4 * _rttvar);
+    }
+  }
+
+  void RttEstimator::addSample(unsigned long rtt) {
+    if (_samples == 0) {
+      _srtt = rtt;
+      _rttvar = rtt / 2;
+    } else {
+      // rttvar = 3/4 rttvar + 1/4 |srtt - rtt|, then srtt = 7/8 srtt + 1/8 rtt
+      unsigned long error = rtt > _srtt ? rtt - _srtt : _srtt - rtt;
+      _rttvar = _rttvar - _rttvar / 4 + error / 4;
+      _srtt = _srtt - _srtt / 8 + rtt / 8;
+    }
+
+    if (_samples < 0xffff) {
+      _samples++;
+    }
+
+    setTimeout(_srtt + 4 * _rttvar);
+  }
+
+  void RttEstimator::backoff() {
+    setTimeout(_timeout < _ceiling / 2 ? _timeout * 2 : _ceiling);
+  }
+
+  void RttEstimator::setTimeout(unsigned long timeout) {
+    if (timeout < _floor) {
+      timeout = _floor;
+    }
+    if (timeout > _ceiling) {
+      timeout = _ceiling;
+    }
+
+    _timeout = timeout;
+  }
+
+  unsigned long RttEstimator::getTimeout() {
+    return _timeout;
+  }
+
+  unsigned long RttEstimator::getSmoothedRtt() {
+    return _srtt;
+  }
+
+  unsigned long RttEstimator::getVariation() {
+    return _rttvar;
+  }
+
+  uint16_t RttEstimator::getSampleCount() {
+    return _samples;
+  }
+}
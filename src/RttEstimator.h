@@ -0,0 +1,61 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __RTT_ESTIMATOR_H__
+#define __RTT_ESTIMATOR_H__
+
+#include <Arduino.h>
+
+#define RTT_TIMEOUT_FLOOR_US 20000UL          // Never time out sooner, however quick the answers have been
+#define RTT_TIMEOUT_CEILING_US 2000000UL      // Nor later
+#define RTT_TIMEOUT_INITIAL_US 100000UL       // Until the first round trip is measured, doubling with each timeout
+
+namespace RunCam {
+
+  // Learns how long a command takes to be answered and picks a timeout from it.  As for TCP retransmits,
+  // the timeout is the smoothed round trip time plus four times its smoothed variation, so it stays just
+  // above what the link is actually doing.  Each timeout doubles it until the next good answer in case the
+  // link has slowed down.
+  class RttEstimator {
+    public:
+      RttEstimator();
+
+      void reset();
+      void setLimits(unsigned long floor, unsigned long ceiling);
+
+      void addSample(unsigned long rtt);
+      void backoff();
+
+      // Microseconds
+      unsigned long getTimeout();
+      unsigned long getSmoothedRtt();
+      unsigned long getVariation();
+      uint16_t getSampleCount();
+
+    private:
+      unsigned long _srtt;
+      unsigned long _rttvar;
+      unsigned long _timeout;
+      unsigned long _floor;
+      unsigned long _ceiling;
+      uint16_t _samples;
+
+      void setTimeout(unsigned long timeout);
+  };
+
+}
+
+#endif // __RTT_ESTIMATOR_H__
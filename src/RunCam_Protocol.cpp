@@ -19,538 +19,1474 @@
 
 #include <Arduino.h>
 #include "RunCam_Protocol.h"
+#include "Crc8.h"
 
 namespace RunCam {
 
-  Protocol::Protocol(UART *uart) {
+  // Fastest first
+  const unsigned long Protocol::BAUD_RATE_CANDIDATES[] = { 921600, 460800, 230400, 115200, 57600, 38400, 19200, 9600 };
+  const uint8_t Protocol::BAUD_RATE_CANDIDATE_COUNT = sizeof(BAUD_RATE_CANDIDATES) / sizeof(BAUD_RATE_CANDIDATES[0]);
+
+  const uint8_t Protocol::RESPONSE_COMMANDS[RESPONSE_COMMAND_COUNT] = {
+    COMMAND_READ_CAMERA_INFO,
+    COMMAND_FIVE_KEY_SIMULATION_PRESS,
+    COMMAND_FIVE_KEY_SIMULATION_RELEASE,
+    COMMAND_FIVE_KEY_SIMULATION_CONNECTION,
+    COMMAND_GET_SETTINGS,
+    COMMAND_READ_SETTING_DETAIL,
+    COMMAND_WRITE_SETTING
+  };
+
+  // -1 for commands without a response
+  int8_t Protocol::getResponseCommandIndex(uint8_t command) {
+    for (uint8_t i = 0; i < RESPONSE_COMMAND_COUNT; i++) {
+      if (RESPONSE_COMMANDS[i] == command) {
+        return i;
+      }
+    }
+
+    return -1;
+  }
+
+  Protocol::Protocol(Transport *uart, unsigned long baudRate) {
     _uart = uart;
 
     // Baud Rate Data Bits Stop Bits Patiry
     // 115200 8 1 none
-    uart->begin(115200, SERIAL_8N1);
+    //
+    // With AUTO_BAUD_RATE the readiness probes cycle through the candidate rates until one is answered
+    _autoBaudRate = baudRate == AUTO_BAUD_RATE;
+    _baudRateIndex = 0;
+    setUartBaudRate(_autoBaudRate ? BAUD_RATE_CANDIDATES[0] : baudRate);
+
+    // Rather than always giving the runcam 3 seconds to send whatever it does out of reset, poll() probes
+    // it with read camera info requests and reports ready as soon as one is answered
+    _startTime = millis();
+    _nextProbeTime = _startTime;
+    _probeBackoff = STARTUP_PROBE_MIN_BACKOFF_MS;
+
+#ifndef RUNCAM_NO_STATS
+    resetStats(&_stats);
+#endif
+  }
+
+  void Protocol::setUartBaudRate(unsigned long baudRate) {
+    if (_baudRate != 0) {
+      _uart->end();
+    }
 
-    // Give the runcam time to send whatever it does out of reset
-    delay(3000);
+    _baudRate = baudRate;
+    _uart->begin(baudRate, SERIAL_8N1);
+
+    // Round trips at the old rate say nothing about the new one
+    for (uint8_t i = 0; i < RESPONSE_COMMAND_COUNT; i++) {
+      _rtt[i].reset();
+    }
   }
 
-  uint8_t Protocol::calcCrc(const uint8_t *buf, const uint8_t numBytes) {
-    uint8_t crc = 0;
+  void Protocol::setTrace(ProtocolTrace *trace) {
+    _trace = trace;
+  }
+
+  ProtocolTrace *Protocol::getTrace() {
+    return _trace;
+  }
+
+  void Protocol::setAdaptiveTimeouts(bool adaptiveTimeouts) {
+    _adaptiveTimeouts = adaptiveTimeouts;
+  }
+
+  void Protocol::setTimeoutLimits(unsigned long floor, unsigned long ceiling) {
+    for (uint8_t i = 0; i < RESPONSE_COMMAND_COUNT; i++) {
+      _rtt[i].setLimits(floor, ceiling);
+    }
+  }
 
-    for (uint8_t i = 0; i < numBytes; i++) {
-      crc = crc8Calc(crc, *(buf ++));
+  // Microseconds.  The estimators learn how long the camera takes to start answering, so the time to send
+  // the request and the longest possible response at the current baud rate is added on top.
+  unsigned long Protocol::getResponseTimeout(uint8_t command, uint8_t requestLength, uint8_t responseLength) {
+    RttEstimator *rtt = getRttEstimator(command);
+    if (!_adaptiveTimeouts || rtt == NULL) {
+      return RESPONSE_TIMEOUT_MS * 1000UL;
     }
 
-    return crc;   
+    if (responseLength == RESPONSE_LENGTH_CHUNKED) {
+      responseLength = RESPONSE_BUFF_SIZE;
+    }
+
+    return rtt->getTimeout() + getWireTime(requestLength + responseLength);
   }
 
-  uint8_t Protocol::crc8Calc(uint8_t crc, unsigned char a) {
-    crc ^= a;
+  // Microseconds to send that many bytes.  8N1 puts 10 bits on the wire for every byte.
+  unsigned long Protocol::getWireTime(size_t length) {
+    return length * ((10000000UL + _baudRate - 1) / _baudRate);
+  }
 
-    for (int i = 0; i < 8; ++i) {
-      if (crc & 0x80) {
-        crc = (crc << 1) ^ 0xd5;
-      } else {
-        crc = crc << 1;
+  RttEstimator *Protocol::getRttEstimator(uint8_t command) {
+    int8_t index = getResponseCommandIndex(command);
+    if (index < 0) {
+      return NULL;
+    }
+
+    return &_rtt[index];
+  }
+
+#ifndef RUNCAM_NO_STATS
+  const ProtocolStats *Protocol::getStats() {
+    return &_stats;
+  }
+
+  void Protocol::clearStats() {
+    resetStats(&_stats);
+  }
+#endif
+
+  unsigned long Protocol::getBaudRate() {
+    return _baudRate;
+  }
+
+  // True once the camera has answered at a rate picked by auto detection
+  bool Protocol::isBaudRateDetected() {
+    return _baudRateDetected;
+  }
+
+  // Payload bytes per second the link can carry.  8N1 puts 10 bits on the wire for every byte.
+  uint32_t Protocol::getThroughput() {
+    return _baudRate / 10;
+  }
+
+  // Try each candidate rate, fastest first, and keep the first one the camera answers with a valid
+  // response.  Returns the rate found, or 0 if the camera didn't answer at any of them in which case the
+  // original rate is restored.
+  unsigned long Protocol::detectBaudRate(const unsigned long *candidates, uint8_t count) {
+    flush();
+
+    unsigned long originalBaudRate = _baudRate;
+    unsigned long tried = 0xffffffff;
+
+    for (uint8_t attempt = 0; attempt < count; attempt++) {
+      // Pick the fastest candidate not tried yet so the order of the list doesn't matter
+      unsigned long baudRate = 0;
+      for (uint8_t i = 0; i < count; i++) {
+        if (candidates[i] < tried && candidates[i] > baudRate) {
+          baudRate = candidates[i];
+        }
+      }
+
+      if (baudRate == 0) {
+        break;
+      }
+
+      tried = baudRate;
+      setUartBaudRate(baudRate);
+
+      if (probe()) {
+        _baudRateDetected = true;
+        return baudRate;
       }
     }
-    
-    return crc;
+
+    setUartBaudRate(originalBaudRate);
+    return 0;
   }
 
-  bool Protocol::checkCrc(const uint8_t *buf, const uint8_t numBytes) {
-    uint8_t crc = calcCrc(buf, numBytes);
+  unsigned long Protocol::detectBaudRate() {
+    return detectBaudRate(BAUD_RATE_CANDIDATES, BAUD_RATE_CANDIDATE_COUNT);
+  }
+
+  // Send a read camera info request with a short timeout.  Unlike the normal blocking calls a failure
+  // is expected here so nothing is logged.
+  bool Protocol::probe() {
+    size_t length = encodeReadCameraInfo(txBuf);
+    unsigned long sendTime = send(txBuf, length);
+    expectResponse(txBuf, length, sendTime, 5, RESPONSE_MAX_CHUNK_DATA, STARTUP_PROBE_TIMEOUT_MS * 1000UL);
+    waitForResponse();
 
-    return crc == 0; // buf[numBytes] == crc;
+    bool answered = _parser.getState() == RESPONSE_PARSER_COMPLETE;
+    _parser.reset();
+
+    return answered;
   }
 
-  bool Protocol::checkCrcAndHeader(const uint8_t * buf, const uint8_t numBytes) {
-    if (!checkCrc(buf, numBytes)) {
-      Serial.println("Bad CRC");
-      return false;
+  bool Protocol::isReady() {
+    poll();
+
+    return _ready;
+  }
+
+  // Returns true if the camera answered, false if the startup timeout expired without a response
+  bool Protocol::waitUntilReady() {
+    while (!isReady()) {
+      yield();
     }
 
-    if (rxBuf[0] != 0xcc) {
-      Serial.println("Bad header");
+    return _cameraDetected;
+  }
+
+  unsigned long Protocol::getStartupTime() {
+    return _startupTime;
+  }
+
+  // The camera info returned by the readiness probe, so callers don't need to ask for it again
+  bool Protocol::getStartupCameraInfo(uint8_t *version, uint16_t *features) {
+    if (!_cameraDetected) {
       return false;
     }
 
+    *version = _startupVersion;
+    *features = _startupFeatures;
     return true;
   }
 
+  void Protocol::processStartup() {
+    unsigned long now = millis();
+
+    if (_probeInFlight) {
+      uint8_t state = _parser.getState();
+      if (state == RESPONSE_PARSER_PENDING) {
+        return;
+      }
+
+      _probeInFlight = false;
+      _parser.reset();
+
+      if (state == RESPONSE_PARSER_COMPLETE) {
+        const uint8_t *rxBuf = _parser.getFrame();
+
+        _startupVersion = rxBuf[1];
+        _startupFeatures = rxBuf[2] | rxBuf[3] << 8;
+        _cameraDetected = true;
+        _baudRateDetected = _autoBaudRate;
+        _ready = true;
+        _startupTime = now - _startTime;
+        return;
+      }
+
+      if (_autoBaudRate) {
+        _baudRateIndex = (_baudRateIndex + 1) % BAUD_RATE_CANDIDATE_COUNT;
+        setUartBaudRate(BAUD_RATE_CANDIDATES[_baudRateIndex]);
+      }
+
+      // Back off so a camera that is still booting isn't flooded with requests.  When detecting the
+      // baud rate only back off once every rate has been tried.
+      if (!_autoBaudRate || _baudRateIndex == 0) {
+        _nextProbeTime = now + _probeBackoff;
+        if (_probeBackoff < STARTUP_PROBE_MAX_BACKOFF_MS) {
+          _probeBackoff *= 2;
+        }
+      }
+    }
+
+    // Give up waiting after the time the camera has always been given, as before
+    if (now - _startTime >= STARTUP_TIMEOUT_MS) {
+      if (_autoBaudRate) {
+        setUartBaudRate(DEFAULT_BAUD_RATE);
+      }
+
+      _ready = true;
+      _startupTime = now - _startTime;
+      return;
+    }
+
+    if ((long)(now - _nextProbeTime) >= 0) {
+      // Sending drains any boot chatter still sitting in the rx buffer
+      size_t length = encodeReadCameraInfo(txBuf);
+      unsigned long sendTime = send(txBuf, length);
+      expectResponse(txBuf, length, sendTime, 5, RESPONSE_MAX_CHUNK_DATA, STARTUP_PROBE_TIMEOUT_MS * 1000UL);
+      _probeInFlight = true;
+    }
+  }
+
+  uint8_t Protocol::calcCrc(const uint8_t *buf, const uint8_t numBytes) {
+    return Crc8::calc(buf, numBytes);
+  }
+
+  uint8_t Protocol::crc8Calc(uint8_t crc, unsigned char a) {
+    return Crc8::update(crc, a);
+  }
+
+  // The parser has already checked the crc and header as the bytes arrived
+  bool Protocol::checkResponse() {
+    uint8_t state = _parser.getState();
+
+    if (state == RESPONSE_PARSER_PENDING) {
+      return false;
+    }
+
+    _parser.reset();
+
+    // Timeouts and bad crcs are counted in the stats, and can be seen in a trace, rather than printed
+    return state == RESPONSE_PARSER_COMPLETE;
+  }
+
   // Flush the serial rx buffer before sending a command to clear any junk making response decoding more reliable
   void Protocol::flushRx() {
     while (_uart->available()) {
-      _uart->read();
+      uint8_t data = _uart->read();
+
+      if (_trace != NULL) {
+        _trace->record(TRACE_EVENT_RX, data);
+      }
+
+#ifndef RUNCAM_NO_STATS
+      _stats.bytesReceived++;
+      _stats.bytesDiscarded++;
+#endif
     }
   }
 
-  void Protocol::send(size_t length) {
-    txBuf[length - 1] = calcCrc(txBuf, length - 1);
+  // Returns when the request started going out.  Commands without a response can be sent while another
+  // command's response is pending, so nothing about the response is recorded here.
+  unsigned long Protocol::send(uint8_t *buf, size_t length) {
+    buf[length - 1] = calcCrc(buf, length - 1);
+
+    // Don't throw away the response to a request that is still in flight
+    if (!isResponsePending()) {
+      flushRx();
+    }
+
+    if (_trace != NULL) {
+      _trace->record(TRACE_EVENT_TX, buf, length);
+    }
+
+#ifndef RUNCAM_NO_STATS
+    CommandStats *commandStats = getCommandStats(&_stats, buf[1]);
 
-    flushRx();
-    _uart->write(txBuf, length);
+    _stats.requests++;
+    _stats.bytesSent += length;
+    if (commandStats != NULL) {
+      commandStats->requests++;
+    }
+#endif
+
+    unsigned long sendTime = micros();
+    _uart->write(buf, length);
+
+    return sendTime;
   }
 
-  int Protocol::fillRxBuffer(size_t count) {
-    return fillRxBuffer(0, count);
+  // Count how the response to the request expectResponse() was last called for ended
+  void Protocol::responseFinished(uint8_t state) {
+    unsigned long rtt = micros() - _responseSendTime;
+
+    if (_trace != NULL) {
+      _trace->record(TRACE_EVENT_RESULT, state);
+    }
+
+    RttEstimator *estimator = getRttEstimator(_responseCommand);
+    if (estimator != NULL) {
+      if (state == RESPONSE_PARSER_COMPLETE) {
+        // Only the camera's own delay is learned, how long the bytes took depends on their number
+        unsigned long wireTime = getWireTime(_responseRequestLength + _parser.getLength() + _parser.getSkippedCount());
+        estimator->addSample(rtt > wireTime ? rtt - wireTime : 0);
+      } else if (state == RESPONSE_PARSER_TIMEOUT) {
+        estimator->backoff();
+      }
+    }
+
+#ifndef RUNCAM_NO_STATS
+    CommandStats *commandStats = getCommandStats(&_stats, _responseCommand);
+
+    _stats.bytesSkipped += _parser.getSkippedCount();
+    _stats.resyncs += _parser.getResyncCount();
+
+    if (state == RESPONSE_PARSER_COMPLETE) {
+      if (commandStats != NULL) {
+        uint32_t latency = rtt;
+        uint8_t bucket = getLatencyBucket(latency);
+
+        commandStats->responses++;
+        commandStats->totalLatency += latency;
+        if (latency < commandStats->minLatency) {
+          commandStats->minLatency = latency;
+        }
+        if (latency > commandStats->maxLatency) {
+          commandStats->maxLatency = latency;
+        }
+        if (commandStats->histogram[bucket] < 0xffff) {
+          commandStats->histogram[bucket]++;
+        }
+      }
+      return;
+    }
+
+    _lastFailed = true;
+
+    if (state == RESPONSE_PARSER_TIMEOUT) {
+      _stats.timeouts++;
+      if (commandStats != NULL) {
+        commandStats->timeouts++;
+      }
+    } else {
+      _stats.errors++;
+      if (commandStats != NULL) {
+        commandStats->errors++;
+      }
+    }
+#endif
   }
 
-  int Protocol::fillRxBuffer(size_t offset, size_t count) {
-    long now = millis();
+  // Wait for the response to the request just sent.  A chunked response with more than maxChunkData bytes of
+  // payload is taken as corrupt.  The timeout is in microseconds.
+  void Protocol::expectResponse(const uint8_t *request, size_t requestLength, unsigned long sendTime, uint8_t responseLength, uint8_t maxChunkData, unsigned long timeout) {
+#ifndef RUNCAM_NO_STATS
+    // A retry asks the same thing again straight after its response failed.  Commands without a response
+    // sent in between don't count as asking something else.
+    if (_lastFailed && request[1] == _responseCommand) {
+      CommandStats *commandStats = getCommandStats(&_stats, request[1]);
+
+      _stats.retries++;
+      if (commandStats != NULL) {
+        commandStats->retries++;
+      }
+    }
 
-    int numRead = 0;
-    do {
-      numRead += _uart->readBytes(rxBuf + offset + numRead, count);
-    } while (count - numRead > 0 && millis() - now < 2000);
+    _lastFailed = false;
+#endif
+
+    _responseCommand = request[1];
+    _responseRequestLength = requestLength;
+    _responseSendTime = sendTime;
+    _requestTime = micros();
+    _responseTimeout = timeout;
+
+    if (_trace != NULL) {
+      _trace->record(TRACE_EVENT_EXPECT, responseLength);
+    }
+
+    if (responseLength == RESPONSE_LENGTH_CHUNKED) {
+      _parser.expectChunked(maxChunkData);
+    } else {
+      _parser.expect(responseLength);
+    }
+  }
+
+  // With the timeout for the request's command
+  void Protocol::expectResponse(const uint8_t *request, size_t requestLength, unsigned long sendTime, uint8_t responseLength, uint8_t maxChunkData) {
+    expectResponse(request, requestLength, sendTime, responseLength, maxChunkData, getResponseTimeout(request[1], requestLength, responseLength));
+  }
+
+  bool Protocol::sendRequest(size_t length, uint8_t responseLength, uint8_t maxChunkData) {
+    if (!_ready || _parser.getState() != RESPONSE_PARSER_IDLE) {
+      return false;
+    }
+
+    unsigned long sendTime = send(txBuf, length);
+    expectResponse(txBuf, length, sendTime, responseLength, maxChunkData);
+
+    return true;
+  }
+
+  bool Protocol::isResponsePending() {
+    return _parser.getState() == RESPONSE_PARSER_PENDING;
+  }
+
+  // Consume whatever bytes are available and move the command queue along without blocking
+  uint8_t Protocol::poll() {
+    if (_parser.getState() == RESPONSE_PARSER_PENDING) {
+      while (_uart->available() > 0) {
+        uint8_t data = _uart->read();
+
+        if (_trace != NULL) {
+          _trace->record(TRACE_EVENT_RX, data);
+        }
+
+#ifndef RUNCAM_NO_STATS
+        _stats.bytesReceived++;
+#endif
+
+        if (_parser.feed(data) != RESPONSE_PARSER_PENDING) {
+          break;
+        }
+      }
+
+      if (_parser.getState() == RESPONSE_PARSER_PENDING && micros() - _requestTime >= _responseTimeout) {
+        if (_trace != NULL) {
+          _trace->record(TRACE_EVENT_TIMEOUT, 0);
+        }
+
+        _parser.timeout();
+      }
+
+      if (_parser.getState() != RESPONSE_PARSER_PENDING) {
+        responseFinished(_parser.getState());
+      }
+    }
+
+    if (!_ready) {
+      processStartup();
+
+      // Nothing is sent from the queue until the camera is ready
+      return RESPONSE_PARSER_PENDING;
+    }
+
+    processQueue();
+
+    return _parser.getState();
+  }
+
+  unsigned long Protocol::getPollDelay() {
+    if (_parser.getState() == RESPONSE_PARSER_PENDING) {
+      unsigned long elapsed = micros() - _requestTime;
+      return elapsed < _responseTimeout ? _responseTimeout - elapsed : 0;
+    }
+
+    if (!_ready) {
+      // Either the next probe or giving up, whichever is first
+      unsigned long now = millis();
+      long untilProbe = (long)(_nextProbeTime - now);
+      unsigned long untilTimeout = now - _startTime < STARTUP_TIMEOUT_MS ? STARTUP_TIMEOUT_MS - (now - _startTime) : 0;
+      if (untilProbe <= 0) {
+        return 0;
+      }
+      return ((unsigned long)untilProbe < untilTimeout ? untilProbe : untilTimeout) * 1000UL;
+    }
+
+    // A queued command's response still has to be completed
+    if (_commandInFlight) {
+      return 0;
+    }
 
-    return numRead;
+    // Nothing is sent while a begin/end response waits to be collected
+    if (_parser.getState() != RESPONSE_PARSER_IDLE || _queue.isEmpty()) {
+      return POLL_DELAY_NONE;
+    }
+
+    return 0;
+  }
+
+  void Protocol::waitForResponse() {
+    while (poll() == RESPONSE_PARSER_PENDING) {
+      yield();
+    }
+  }
+
+  // Block until the camera is ready and every queued command has completed
+  void Protocol::flush() {
+    while (!_ready || !_queue.isEmpty() || isResponsePending()) {
+      poll();
+      yield();
+    }
+  }
+
+  uint8_t Protocol::getQueuedCommandCount() {
+    return _queue.size();
+  }
+
+  void Protocol::processQueue() {
+    if (_commandInFlight) {
+      if (_parser.getState() == RESPONSE_PARSER_PENDING) {
+        return;
+      }
+
+      completeCommand(_queue.front());
+    }
+
+    // Commands without a response are sent back to back, a command with a response waits for it to arrive
+    while (!_queue.isEmpty() && _parser.getState() == RESPONSE_PARSER_IDLE) {
+      QueuedCommand *command = _queue.front();
+
+      unsigned long sendTime = send(command->buf, command->length);
+
+      if (command->responseLength == RESPONSE_LENGTH_NONE) {
+        completeCommand(command);
+      } else {
+        expectResponse(command->buf, command->length, sendTime, command->responseLength, command->maxChunkData);
+        _commandInFlight = true;
+      }
+    }
+  }
+
+  void Protocol::completeCommand(QueuedCommand *command) {
+    CommandResult result;
+    memset(&result, 0, sizeof(result));
+    result.handle = command->handle;
+    result.command = command->buf[1];
+    result.remainingChunks = -1;
+
+    // Copy out what is needed so the slot can be released before the callback runs.  This lets the
+    // callback queue more commands or even make a blocking call.
+    uint8_t settingId = command->buf[2];
+    uint8_t responseLength = command->responseLength;
+    void *target = command->target;
+    uint8_t targetType = command->targetType;
+    CommandCallbackFuncPtr callback = command->callback;
+    void *context = command->context;
+
+    _queue.pop();
+    _commandInFlight = false;
+
+    if (responseLength == RESPONSE_LENGTH_NONE) {
+      result.success = true;
+    } else if (checkResponse()) {
+      const uint8_t *rxBuf = _parser.getFrame();
+
+      switch (result.command) {
+        case COMMAND_READ_CAMERA_INFO:
+          result.success = true;
+          result.version = rxBuf[1];
+          result.features = rxBuf[2] | rxBuf[3] << 8;
+          break;
+
+        case COMMAND_FIVE_KEY_SIMULATION_CONNECTION:
+          result.success = (rxBuf[1] & 0x1) != 0;
+          break;
+
+        case COMMAND_GET_SETTINGS:
+          if (targetType == COMMAND_TARGET_STORE) {
+            result.remainingChunks = decodeSettings(rxBuf, (SettingsStore*)target);
+          }
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+          if (targetType == COMMAND_TARGET_VECTOR) {
+            result.remainingChunks = decodeSettings(rxBuf, (std::vector<RunCam::Setting*>*)target);
+          }
+#endif
+          result.success = true;
+          break;
+
+        case COMMAND_READ_SETTING_DETAIL:
+          if (targetType == COMMAND_TARGET_STORE) {
+            result.remainingChunks = decodeSettingDetails(settingId, rxBuf, (SettingsStore*)target);
+          }
+          result.success = true;
+          break;
+
+        case COMMAND_WRITE_SETTING:
+          result.resultCode = rxBuf[1];
+          result.refresh = rxBuf[2];
+          result.success = result.resultCode == 0;
+          break;
+
+        default:
+          result.success = true;
+          break;
+      }
+    }
+
+    if (callback != NULL) {
+      callback(result, context);
+    }
+  }
+
+  uint16_t Protocol::submit(QueuedCommand *command, size_t length, uint8_t responseLength, CommandCallbackFuncPtr callback, void *context, uint8_t maxChunkData) {
+    if (command == NULL || length == 0) {
+      return 0;
+    }
+
+    command->length = length;
+    command->responseLength = responseLength;
+    command->maxChunkData = maxChunkData;
+    command->callback = callback;
+    command->context = context;
+
+    return _queue.commit();
+  }
+
+  size_t Protocol::encodeReadCameraInfo(uint8_t *buf) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_READ_CAMERA_INFO;
+
+    return 3;
   }
 
   // Read the basic information of the camera, such as firmware version, device type, protocol version
   bool Protocol::readCameraInfo(uint8_t *version, uint16_t *features) {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_READ_CAMERA_INFO;
+    flush();
 
-    send(3);
-    fillRxBuffer(5);
+    if (!beginReadCameraInfo()) {
+      return false;
+    }
+
+    waitForResponse();
+
+    return endReadCameraInfo(version, features);
+  }
+
+  bool Protocol::beginReadCameraInfo() {
+    return sendRequest(encodeReadCameraInfo(txBuf), 5);
+  }
 
-    if (!checkCrcAndHeader(rxBuf, 5)) {
+  bool Protocol::endReadCameraInfo(uint8_t *version, uint16_t *features) {
+    if (!checkResponse()) {
       return false;
     }
 
+    const uint8_t *rxBuf = _parser.getFrame();
+
     *version = rxBuf[1];
     *features = rxBuf[2] | rxBuf[3] << 8;
     return true;
   }
 
+  uint16_t Protocol::submitReadCameraInfo(CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    return submit(command, encodeReadCameraInfo(command->buf), 5, callback, context);
+  }
+
+  size_t Protocol::encodeCameraControl(uint8_t *buf, uint8_t actionId) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_CAMERA_CONTROL;
+    buf[2] = actionId;
+
+    return 4;
+  }
+
   // Camera control，For example: through this instruction, send an instruction to simulate the actions of power button to the camera
   bool Protocol::cameraControl(uint8_t actionId) {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_CAMERA_CONTROL;
-    txBuf[2] = actionId;
+    flush();
 
-    send(4);
+    send(txBuf, encodeCameraControl(txBuf, actionId));
 
     // Device does not produce a response
     return true;
   }
 
+  uint16_t Protocol::submitCameraControl(uint8_t actionId, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    return submit(command, encodeCameraControl(command->buf, actionId), RESPONSE_LENGTH_NONE, callback, context);
+  }
+
+  size_t Protocol::encodeFiveKeySimulationPress(uint8_t *buf, uint8_t actionId) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_FIVE_KEY_SIMULATION_PRESS;
+    buf[2] = actionId;  
+
+    return 4;
+  }
+
   bool Protocol::fiveKeySimulationPress(uint8_t actionId) {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_FIVE_KEY_SIMULATION_PRESS;
-    txBuf[2] = actionId;  
+    flush();
+
+    if (!beginFiveKeySimulationPress(actionId)) {
+      return false;
+    }
 
-    send(4);
+    waitForResponse();
 
-    fillRxBuffer(2);
+    return endFiveKeySimulation();
+  }
 
-    return checkCrcAndHeader(rxBuf, 2);
+  bool Protocol::beginFiveKeySimulationPress(uint8_t actionId) {
+    return sendRequest(encodeFiveKeySimulationPress(txBuf, actionId), 2);
+  }
+
+  uint16_t Protocol::submitFiveKeySimulationPress(uint8_t actionId, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    return submit(command, encodeFiveKeySimulationPress(command->buf, actionId), 2, callback, context);
+  }
+
+  size_t Protocol::encodeFiveKeySimulationRelease(uint8_t *buf) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_FIVE_KEY_SIMULATION_RELEASE;
+
+    return 3;
   }
 
   bool Protocol::fiveKeySimulationRelease() {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_FIVE_KEY_SIMULATION_RELEASE;
-    
-    send(3);
+    flush();
+
+    if (!beginFiveKeySimulationRelease()) {
+      return false;
+    }
 
-    fillRxBuffer(2);
+    waitForResponse();
 
-    return checkCrcAndHeader(rxBuf, 2);
+    return endFiveKeySimulation();
+  }
+
+  bool Protocol::beginFiveKeySimulationRelease() {
+    return sendRequest(encodeFiveKeySimulationRelease(txBuf), 2);
+  }
+
+  uint16_t Protocol::submitFiveKeySimulationRelease(CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    return submit(command, encodeFiveKeySimulationRelease(command->buf), 2, callback, context);
+  }
+
+  // Press and release responses carry no data
+  bool Protocol::endFiveKeySimulation() {
+    return checkResponse();
+  }
+
+  size_t Protocol::encodeFiveKeySimulationConnection(uint8_t *buf, uint8_t actionId) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_FIVE_KEY_SIMULATION_CONNECTION;
+    buf[2] = actionId;  
+
+    return 4;
   }
 
   // Send handshake events and disconnected events to the camera
   bool Protocol::fiveKeySimulationConnection(uint8_t actionId) {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_FIVE_KEY_SIMULATION_CONNECTION;
-    txBuf[2] = actionId;  
+    flush();
+
+    if (!beginFiveKeySimulationConnection(actionId)) {
+      return false;
+    }
+
+    waitForResponse();
 
-    send(4);
-    fillRxBuffer(3);
+    return endFiveKeySimulationConnection();
+  }
+
+  bool Protocol::beginFiveKeySimulationConnection(uint8_t actionId) {
+    return sendRequest(encodeFiveKeySimulationConnection(txBuf, actionId), 3);
+  }
 
-    if (!checkCrcAndHeader(rxBuf, 3)) {
+  bool Protocol::endFiveKeySimulationConnection() {
+    if (!checkResponse()) {
       return false;
     }
 
+    const uint8_t *rxBuf = _parser.getFrame();
+
     // [ (Action ID << 4) + Response result(1：Succes 0：Failure) ]
-    return rxBuf[1] & 0x1 != 0;
+    return (rxBuf[1] & 0x1) != 0;
   }
 
-  size_t safe_strlen(const uint8_t *str, size_t max_len) {
-    const uint8_t * end = (const uint8_t *)memchr(str, '\0', max_len);
-    if (end == NULL) {
-      return max_len;
-    } else {
-      return end - str;
+  uint16_t Protocol::submitFiveKeySimulationConnection(uint8_t actionId, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
     }
+
+    return submit(command, encodeFiveKeySimulationConnection(command->buf, actionId), 3, callback, context);
   }
 
   size_t safe_strlen(const uint8_t *start, const uint8_t* maxPtr) {
     const uint8_t *end = start;
-    while (*end != 0 && end < maxPtr) {
+    while (end < maxPtr && *end != 0) {
       end++;
     }
 
     return end - start;
   }
 
+  size_t Protocol::encodeGetSetting(uint8_t *buf, uint8_t chunkIndex) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_GET_SETTINGS;
+    buf[2] = 0;   // setting Id - Retrieve the sub settings through the parent setting ID.  Changing the value doesnt seem to make a difference
+    buf[3] = chunkIndex;
+
+    return 5;
+  }
+
   // get a setting
   // Enumerates the possible settings and their current values
-  int Protocol::getSetting(uint8_t chunkIndex, std::vector<RunCam::Setting*> *settings) {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_GET_SETTINGS;
-    txBuf[2] = 0;   // setting Id - Retrieve the sub settings through the parent setting ID.  Changing the value doesnt seem to make a difference
-    txBuf[3] = chunkIndex;
+  int Protocol::getSetting(uint8_t chunkIndex, SettingsStore *store) {
+    flush();
 
-    send(5);
+    if (!beginGetSetting(chunkIndex)) {
+      return -1;
+    }
 
-    fillRxBuffer(3);
+    waitForResponse();
 
-    uint8_t remainingChunks = rxBuf[1];   // 3   <- Remaining chunks
-    uint8_t dataLength = rxBuf[2];        // 24  <- data length
+    return endGetSetting(store);
+  }
 
-    // Read the payload + crc
-    fillRxBuffer(3, dataLength + 1);
+  bool Protocol::beginGetSetting(uint8_t chunkIndex) {
+    return sendRequest(encodeGetSetting(txBuf, chunkIndex), RESPONSE_LENGTH_CHUNKED, SETTINGS_CHUNK_MAX_DATA);
+  }
 
+  int Protocol::endGetSetting(SettingsStore *store) {
     // Check the CRC
-    if (!checkCrcAndHeader(rxBuf, dataLength + 4)) {
-      // Serial.println("Bad CRC");
+    if (!checkResponse()) {
       return -1;
     }
 
+    return decodeSettings(_parser.getFrame(), store);
+  }
+
+  uint16_t Protocol::submitGetSetting(uint8_t chunkIndex, SettingsStore *store, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    command->target = store;
+    command->targetType = COMMAND_TARGET_STORE;
+    return submit(command, encodeGetSetting(command->buf, chunkIndex), RESPONSE_LENGTH_CHUNKED, callback, context, SETTINGS_CHUNK_MAX_DATA);
+  }
+
+  int Protocol::decodeSettings(const uint8_t *rxBuf, SettingsStore *store) {
+    uint8_t remainingChunks = rxBuf[1];
+    uint8_t dataLength = rxBuf[2];
+
     const uint8_t* endPtr = rxBuf + dataLength + 4;
-    uint8_t* chunkPtr = rxBuf + 3;
+    const uint8_t* chunkPtr = rxBuf + 3;
 
     do {
       uint8_t settingId = *(chunkPtr++);
 
       size_t nameLength = safe_strlen(chunkPtr, endPtr);
-      String name = String(chunkPtr, nameLength);
+      const uint8_t *name = chunkPtr;
       chunkPtr += nameLength + 1;
 
       size_t valueLength = safe_strlen(chunkPtr, endPtr);
-      String value = String(chunkPtr, valueLength);
+      const uint8_t *value = chunkPtr;
       chunkPtr += valueLength + 1;
 
-      settings->push_back(new RunCam::Setting(settingId, name, value));
+      // Settings that don't fit are dropped, the rest of the chunk is still decoded
+      SettingRecord *record = store->add(settingId);
+      if (record != NULL) {
+        record->nameOffset = store->setString(record->nameOffset, name, nameLength);
+        record->valueOffset = store->setString(record->valueOffset, value, valueLength);
+        record->updateTime = millis();
+        record->stale = false;
+      }
 
     } while (chunkPtr + 1 < rxBuf + dataLength + 4);
 
     return remainingChunks;
   }
 
+  size_t Protocol::encodeReadSettingDetail(uint8_t *buf, uint8_t settingId, uint8_t chunkIndex) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_READ_SETTING_DETAIL;
+    buf[2] = settingId;
+    buf[3] = chunkIndex;
+
+    return 5;
+  }
+
   // Retrieve the detail of setting, e.g it's maybe including max value, min value and etc. This command can not be called for the setting type with Folder and Static
-  int Protocol::readSettingDetail(uint8_t settingId, uint8_t chunkIndex, std::vector<RunCam::SettingDetail*> *settingDetails) {    
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_READ_SETTING_DETAIL;
-    txBuf[2] = settingId;
-    txBuf[3] = chunkIndex;
+  int Protocol::readSettingDetail(uint8_t settingId, uint8_t chunkIndex, SettingsStore *store) {
+    flush();
 
-    send(5);
+    if (!beginReadSettingDetail(settingId, chunkIndex)) {
+      return -1;
+    }
 
-    // Read the header
-    fillRxBuffer(3);
+    waitForResponse();
 
-    uint8_t remainingChunkCount = rxBuf[1];
-    uint8_t dataLength = rxBuf[2];
+    return endReadSettingDetail(store);
+  }
 
-    // Read the payload + crc
-    fillRxBuffer(3, dataLength + 1);
+  bool Protocol::beginReadSettingDetail(uint8_t settingId, uint8_t chunkIndex) {
+    // Don't change the id under a response that hasn't been ended yet
+    if (!_ready || _parser.getState() != RESPONSE_PARSER_IDLE) {
+      return false;
+    }
 
+    _detailSettingId = settingId;
+    return sendRequest(encodeReadSettingDetail(txBuf, settingId, chunkIndex), RESPONSE_LENGTH_CHUNKED, SETTINGS_CHUNK_MAX_DATA);
+  }
+
+  int Protocol::endReadSettingDetail(SettingsStore *store) {
     // Check the CRC
-    if (!checkCrcAndHeader(rxBuf, dataLength + 4)) {
-      Serial.println("Bad CRC");
+    if (!checkResponse()) {
       return -1;
     }
 
-    /*for (int i = 0; i < dataLength + 4; i++) {
-      Serial.print(rxBuf[i]);
-      Serial.print(' ');
+    // The setting id is not echoed in the response so take it from the request.  Display writes sent since
+    // may have reused txBuf.
+    return decodeSettingDetails(_detailSettingId, _parser.getFrame(), store);
+  }
+
+  uint16_t Protocol::submitReadSettingDetail(uint8_t settingId, uint8_t chunkIndex, SettingsStore *store, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
     }
-    Serial.println();*/
 
-    int p = 3; 
-    while (p <= dataLength + 2) {
-      uint8_t settingType = rxBuf[p++];             // The type of setting，refer to 'setting type' section to know more
+    command->target = store;
+    command->targetType = COMMAND_TARGET_STORE;
+    return submit(command, encodeReadSettingDetail(command->buf, settingId, chunkIndex), RESPONSE_LENGTH_CHUNKED, callback, context, SETTINGS_CHUNK_MAX_DATA);
+  }
 
-      switch (settingType) {
-        case SETTING_TYPE_UINT8: {
-          uint8_t value = rxBuf[p++];
-          uint8_t min = rxBuf[p++];
-          uint8_t max = rxBuf[p++];
-          uint8_t stepSize = rxBuf[p++];
+  static int16_t readInt16(const uint8_t *rxBuf, int *p) {
+    int16_t value = rxBuf[*p] | (rxBuf[*p + 1] << 8);
+    *p += 2;
+    return value;
+  }
 
-          settingDetails->push_back(new UInt8SettingDetail(settingId, settingType, value, min, max, stepSize));
+  static int32_t readInt32(const uint8_t *rxBuf, int *p) {
+    int32_t value = (uint32_t)rxBuf[*p] | ((uint32_t)rxBuf[*p + 1] << 8) | ((uint32_t)rxBuf[*p + 2] << 16) | ((uint32_t)rxBuf[*p + 3] << 24);
+    *p += 4;
+    return value;
+  }
 
-          break;
-        }
+  // Copies a NUL terminated string out of the response into the store, reusing the slot at offset if it
+  // fits, and advances p past it
+  static uint16_t readText(const uint8_t *rxBuf, int *p, const uint8_t *endPtr, SettingsStore *store, uint16_t offset, size_t *length) {
+    *length = safe_strlen(&rxBuf[*p], endPtr);
+    offset = store->setString(offset, &rxBuf[*p], *length);
+    *p += *length + 1;
+    return offset;
+  }
 
-        case SETTING_TYPE_INT8: {
-          int8_t value = rxBuf[p++];
-          int8_t min = rxBuf[p++];
-          int8_t max = rxBuf[p++];
-          int8_t stepSize = rxBuf[p++];
+  // Decodes the detail starting at rxBuf[p] into value, copying any text into the store.  Text replaces
+  // the text of the previous value where it fits.  Folders and unknown types leave value empty.  Returns
+  // the position of the next detail.
+  int Protocol::parseSettingDetail(const uint8_t *rxBuf, int p, const uint8_t *endPtr, SettingsStore *store, SettingValue *value) {
+    uint8_t settingType = rxBuf[p++];             // The type of setting，refer to 'setting type' section to know more
+    uint16_t textOffset = value->getTextOffset();
+    size_t length;
+
+    value->clear();
+
+    switch (settingType) {
+      case SETTING_TYPE_UINT8: {
+        value->setUInt8(rxBuf[p], rxBuf[p + 1], rxBuf[p + 2], rxBuf[p + 3]);
+        p += 4;
+        break;
+      }
 
-          settingDetails->push_back(new Int8SettingDetail(settingId, settingType, value, min, max, stepSize));
+      case SETTING_TYPE_INT8: {
+        value->setInt8(rxBuf[p], rxBuf[p + 1], rxBuf[p + 2], rxBuf[p + 3]);
+        p += 4;
+        break;
+      }
 
-          break;
-        }
+      case SETTING_TYPE_UINT16: {
+        uint16_t current = readInt16(rxBuf, &p);
+        uint16_t min = readInt16(rxBuf, &p);
+        uint16_t max = readInt16(rxBuf, &p);
+        uint16_t stepSize = readInt16(rxBuf, &p);
+        value->setUInt16(current, min, max, stepSize);
+        break;
+      }
 
-        case SETTING_TYPE_UINT16: {
-          uint16_t value = rxBuf[p++] | (rxBuf[p++] << 8);
-          uint16_t min = rxBuf[p++] | (rxBuf[p++] << 8);
-          uint16_t max = rxBuf[p++] | (rxBuf[p++] << 8);
-          uint16_t stepSize = rxBuf[p++] | (rxBuf[p++] << 8);
+      case SETTING_TYPE_INT16: {
+        int16_t current = readInt16(rxBuf, &p);
+        int16_t min = readInt16(rxBuf, &p);
+        int16_t max = readInt16(rxBuf, &p);
+        int16_t stepSize = readInt16(rxBuf, &p);
+        value->setInt16(current, min, max, stepSize);
+        break;
+      }
 
-          settingDetails->push_back(new UInt16SettingDetail(settingId, settingType, value, min, max, stepSize));
+      case SETTING_TYPE_FLOAT: {
+        int32_t current = readInt32(rxBuf, &p);
+        int32_t min = readInt32(rxBuf, &p);
+        int32_t max = readInt32(rxBuf, &p);
+        int16_t decimalPoint = readInt16(rxBuf, &p);    // Digit count after the decimal point
+        int32_t stepSize = readInt32(rxBuf, &p);
+        value->setFloat(current, min, max, decimalPoint, stepSize);
+        break;
+      }
 
-          break;
+      case SETTING_TYPE_TEXT_SELECTION: {
+        uint8_t current = rxBuf[p++];
+        uint16_t offset = readText(rxBuf, &p, endPtr, store, textOffset, &length);
+
+        // Split the ';' separated options in place so each can be handed out as a C string
+        uint8_t optionCount = 0;
+        if (offset != SETTINGS_STORE_NO_STRING) {
+          char *option = (char*)store->getString(offset);
+          optionCount = 1;
+          for (size_t i = 0; i < length; i++) {
+            if (option[i] == ';') {
+              option[i] = 0;
+              optionCount++;
+            }
+          }
         }
 
-        case SETTING_TYPE_INT16: {
-          int16_t value = rxBuf[p++] | (rxBuf[p++] << 8);
-          int16_t min = rxBuf[p++] | (rxBuf[p++] << 8);
-          int16_t max = rxBuf[p++] | (rxBuf[p++] << 8);
-          int16_t stepSize = rxBuf[p++] | (rxBuf[p++] << 8);
-
-          settingDetails->push_back(new Int16SettingDetail(settingId, settingType, value, min, max, stepSize));
-
-          break;
-        }
+        value->setTextSelection(current, optionCount, offset);
+        break;
+      }
 
-        case SETTING_TYPE_FLOAT: {
-          float value = rxBuf[p++] | (rxBuf[p++] << 8) | (rxBuf[p++] << 16) | (rxBuf[p++] << 24);
-          float min = rxBuf[p++] | (rxBuf[p++] << 8) | (rxBuf[p++] << 16) | (rxBuf[p++] << 24);
-          float max = rxBuf[p++] | (rxBuf[p++] << 8) | (rxBuf[p++] << 16) | (rxBuf[p++] << 24);
-          int16_t decimalPoint = rxBuf[p++] | (rxBuf[p++] << 8);            // Digit count after the decimal point
-          int32_t stepSize = rxBuf[p++] | (rxBuf[p++] << 8) | (rxBuf[p++] << 16) | (rxBuf[p++] << 24);
+      case SETTING_TYPE_STRING: {
+        uint16_t offset = readText(rxBuf, &p, endPtr, store, textOffset, &length);
+        value->setString(offset, rxBuf[p++]);
+        break;
+      }
 
-          settingDetails->push_back(new FloatSettingDetail(settingId, settingType, value, min, max, decimalPoint, stepSize));
+      case SETTING_TYPE_INFO: {
+        value->setInfo(readText(rxBuf, &p, endPtr, store, textOffset, &length));
+        break;
+      }
 
-          break;
-        }
+      default: {
+        // Folders have no detail, unknown types are skipped a byte at a time
+        break;
+      }
+    }
 
-        case SETTING_TYPE_TEXT_SELECTION: {
-          uint8_t value = rxBuf[p++];
+    return p;
+  }
 
-          std::vector<String*> *textSelection = new std::vector<String*>();
+  int Protocol::decodeSettingDetails(uint8_t settingId, const uint8_t *rxBuf, SettingsStore *store) {
+    uint8_t remainingChunkCount = rxBuf[1];
+    uint8_t dataLength = rxBuf[2];
+    const uint8_t *endPtr = rxBuf + dataLength + 3;
 
-          size_t len = 0;
-          while (p + len < dataLength + 3) {
-            uint8_t c = rxBuf[p + len];
+    SettingValue value;
 
-            if (c == ';' || c == 0) {
-              textSelection->push_back(new String(&rxBuf[p], len));
+    int p = 3;
+    while (p <= dataLength + 2) {
+      // Start from the current detail so its text can be updated in place
+      SettingRecord *record = store->find(settingId);
+      if (record != NULL) {
+        value = record->detail;
+      } else {
+        value.clear();
+      }
 
-              p += len + 1;
-              len = 0;
+      p = parseSettingDetail(rxBuf, p, endPtr, store, &value);
 
-              if (c == 0) {
-                break;
-              }
-            } else {
-              len++;
-            }
-          }
+      if (value.isEmpty()) {
+        continue;
+      }
 
-          settingDetails->push_back(new TextSelectionSettingDetail(settingId, settingType, value, textSelection));
+      if (record == NULL) {
+        record = store->add(settingId);
+      }
 
-          break;
-        }
+      if (record != NULL) {
+        record->detail = value;
+        record->updateTime = millis();
+        record->stale = false;
+      }
+    }
 
-        case SETTING_TYPE_STRING: {
-          size_t len = safe_strlen(&rxBuf[p], dataLength - p + 2);
-          String value = String(&rxBuf[p], len);
-          p += len + 1;
+    return remainingChunkCount;
+  }
 
-          uint8_t maxStringSize = rxBuf[p++];
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+  int Protocol::getSetting(uint8_t chunkIndex, std::vector<RunCam::Setting*> *settings) {
+    flush();
 
-          settingDetails->push_back(new StringSettingDetail(settingId, settingType, value, maxStringSize));
+    if (!beginGetSetting(chunkIndex)) {
+      return -1;
+    }
 
-          break;
-        }
+    waitForResponse();
 
-        case SETTING_TYPE_FOLDER: {
-          break;
-        }
+    return endGetSetting(settings);
+  }
 
-        case SETTING_TYPE_INFO: {
-          size_t len = safe_strlen(&rxBuf[p], dataLength - p + 2);
-          String value = String(&rxBuf[p], len);
-          p += len + 1;
-          
-          settingDetails->push_back(new InfoSettingDetail(settingId, settingType, value));
+  int Protocol::endGetSetting(std::vector<RunCam::Setting*> *settings) {
+    // Check the CRC
+    if (!checkResponse()) {
+      return -1;
+    }
 
-          break;
-        }
+    return decodeSettings(_parser.getFrame(), settings);
+  }
 
-        default: {
-          // Serial.print(settingType);
-          // Serial.println(" - Unknown");
-          break;
-        }
-      }
+  uint16_t Protocol::submitGetSetting(uint8_t chunkIndex, std::vector<RunCam::Setting*> *settings, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
     }
 
-    return remainingChunkCount;
+    command->target = settings;
+    command->targetType = COMMAND_TARGET_VECTOR;
+    return submit(command, encodeGetSetting(command->buf, chunkIndex), RESPONSE_LENGTH_CHUNKED, callback, context, SETTINGS_CHUNK_MAX_DATA);
   }
 
-  // change the value of special setting，can't call this command with the setting type of FOLDER and INFO
-  bool Protocol::writeSetting(uint8_t settingId, uint8_t value) {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_WRITE_SETTING;
-    txBuf[2] = settingId;
-    txBuf[3] = value;
+  int Protocol::decodeSettings(const uint8_t *rxBuf, std::vector<RunCam::Setting*> *settings) {
+    uint8_t remainingChunks = rxBuf[1];   // 3   <- Remaining chunks
+    uint8_t dataLength = rxBuf[2];        // 24  <- data length
 
-    send(5);
+    const uint8_t* endPtr = rxBuf + dataLength + 4;
+    const uint8_t* chunkPtr = rxBuf + 3;
 
-    // Read the response
-    fillRxBuffer(4);
+    do {
+      uint8_t settingId = *(chunkPtr++);
 
-    for (int i = 0; i < 4; i++) {
-      Serial.print(rxBuf[i]);
-      Serial.print(' ');
-    }
-    Serial.println();
+      size_t nameLength = safe_strlen(chunkPtr, endPtr);
+      String name = String(chunkPtr, nameLength);
+      chunkPtr += nameLength + 1;
 
-    if (!checkCrcAndHeader(rxBuf, 4)) {
-      return false;
-    }
+      size_t valueLength = safe_strlen(chunkPtr, endPtr);
+      String value = String(chunkPtr, valueLength);
+      chunkPtr += valueLength + 1;
 
-    uint8_t resultCode = rxBuf[1];    // if value is 0, it means write operation succeed 
-    uint8_t refresh = rxBuf[2];
+      settings->push_back(new RunCam::Setting(settingId, name, value));
 
-    return resultCode == 0;
+    } while (chunkPtr + 1 < rxBuf + dataLength + 4);
+
+    return remainingChunks;
   }
+#endif
 
-  bool Protocol::writeSetting(uint8_t settingId, const String &value) {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_WRITE_SETTING;
-    txBuf[2] = settingId;
+  size_t Protocol::encodeWriteSetting(uint8_t *buf, uint8_t settingId, uint8_t value) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_WRITE_SETTING;
+    buf[2] = settingId;
+    buf[3] = value;
+
+    return 5;
+  }
 
+  size_t Protocol::encodeWriteSetting(uint8_t *buf, uint8_t settingId, const String &value) {
     int length = value.length();
 
-    txBuf[3] = length;// + 1;
+    // Max buffer must not exceed 65 bytes
+    if (length > 60) {
+      return 0;
+    }
+
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_WRITE_SETTING;
+    buf[2] = settingId;
+    buf[3] = length;// + 1;
 
     for (int i = 0; i < length; i++) {
-      txBuf[i + 4] = value.charAt(i);
+      buf[i + 4] = value.charAt(i);
+    }
+
+    // The crc follows the last character
+    return length + 5;
+  }
+
+  // change the value of special setting，can't call this command with the setting type of FOLDER and INFO
+  bool Protocol::writeSetting(uint8_t settingId, uint8_t value, bool *needsRefresh) {
+    flush();
+
+    if (!beginWriteSetting(settingId, value)) {
+      return false;
     }
 
-    //txBuf[length + 4] = 0;
+    waitForResponse();
+
+    return endWriteSetting(needsRefresh);
+  }
 
-    send(length + 4);
+  bool Protocol::writeSetting(uint8_t settingId, const String &value, bool *needsRefresh) {
+    flush();
 
-    // Read the response
-    int numRead = fillRxBuffer(4);
+    if (!beginWriteSetting(settingId, value)) {
+      return false;
+    }
 
-    Serial.println(numRead);
+    waitForResponse();
 
-    for (int i = 0; i < 4; i++) {
-      Serial.print(rxBuf[i]);
-      Serial.print(' ');
+    return endWriteSetting(needsRefresh);
+  }
+
+  bool Protocol::beginWriteSetting(uint8_t settingId, uint8_t value) {
+    return sendRequest(encodeWriteSetting(txBuf, settingId, value), 4);
+  }
+
+  bool Protocol::beginWriteSetting(uint8_t settingId, const String &value) {
+    size_t length = encodeWriteSetting(txBuf, settingId, value);
+    if (length == 0) {
+      return false;
     }
-    Serial.println();
 
-    if (!checkCrcAndHeader(rxBuf, 4)) {
+    return sendRequest(length, 4);
+  }
+
+  bool Protocol::endWriteSetting(bool *needsRefresh) {
+    if (!checkResponse()) {
       return false;
     }
 
+    const uint8_t *rxBuf = _parser.getFrame();
+
     uint8_t resultCode = rxBuf[1];    // if value is 0, it means write operation succeed 
-    uint8_t refresh = rxBuf[2];
+    uint8_t refresh = rxBuf[2];       // if not 0, other settings changed and need reading again
+
+    if (needsRefresh != NULL) {
+      *needsRefresh = refresh != 0;
+    }
 
     return resultCode == 0;
   }
 
+  uint16_t Protocol::submitWriteSetting(uint8_t settingId, uint8_t value, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    return submit(command, encodeWriteSetting(command->buf, settingId, value), 4, callback, context);
+  }
+
+  uint16_t Protocol::submitWriteSetting(uint8_t settingId, const String &value, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    return submit(command, encodeWriteSetting(command->buf, settingId, value), 4, callback, context);
+  }
+
+  size_t Protocol::encodeDisplayFillRegion(uint8_t *buf, uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_DISPLAY_FILL_REGION;
+    buf[2] = x;
+    buf[3] = y;
+    buf[4] = width;
+    buf[5] = height;
+    buf[6] = character;
+
+    return 8;
+  }
+
   // Fill an area with a specified char
   void Protocol::displayFillRegion(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character) {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_DISPLAY_FILL_REGION;
-    txBuf[2] = x;
-    txBuf[3] = y;
-    txBuf[4] = width;
-    txBuf[5] = height;
-    txBuf[6] = character;
+    waitUntilReady();
+
+    send(txBuf, encodeDisplayFillRegion(txBuf, x, y, width, height, character));
+  }
 
-    send(8);
+  uint16_t Protocol::submitDisplayFillRegion(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    return submit(command, encodeDisplayFillRegion(command->buf, x, y, width, height, character), RESPONSE_LENGTH_NONE, callback, context);
+  }
+
+  size_t Protocol::encodeDisplayWriteChar(uint8_t *buf, uint8_t x, uint8_t y, uint8_t character) {
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_DISPLAY_WRITE_CHAR;
+    buf[2] = x;
+    buf[3] = y;
+    buf[4] = character;
+
+    return 6;
   }
 
   // Write a character at the specified position
   void Protocol::displayWriteChar(uint8_t x, uint8_t y, uint8_t character) {
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_DISPLAY_WRITE_CHAR;
-    txBuf[2] = x;
-    txBuf[3] = y;
-    txBuf[4] = character;
+    waitUntilReady();
 
-    send(6);
+    send(txBuf, encodeDisplayWriteChar(txBuf, x, y, character));
+  }
+
+  uint16_t Protocol::submitDisplayWriteChar(uint8_t x, uint8_t y, uint8_t character, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    return submit(command, encodeDisplayWriteChar(command->buf, x, y, character), RESPONSE_LENGTH_NONE, callback, context);
+  }
+
+  size_t Protocol::encodeDisplayWriteString(uint8_t *buf, uint8_t command, uint8_t maxLength, uint8_t x, uint8_t y, const uint8_t *string, uint8_t length) {
+    if (length > maxLength) {
+      return 0;
+    }
+
+    buf[0] = COMMAND_HEADER;
+    buf[1] = command;
+    buf[2] = length;
+    buf[3] = x;
+    buf[4] = y;
+
+    for (uint8_t i = 0; i < length; i++) {
+      buf[i + 5] = string[i];    
+    }
+
+    return length + 6;
   }
 
   // Write a string horizonally at the specified position
   bool Protocol::displayWriteHorizontalString(uint8_t x, uint8_t y, const String &string) {
-    int length = string.length();
+    return displayWriteHorizontalString(x, y, (const uint8_t *)string.c_str(), string.length());
+  }
 
+  bool Protocol::displayWriteHorizontalString(uint8_t x, uint8_t y, const uint8_t *string, uint8_t stringLength) {
     // Max buffer must not exceed 65 bytes.  Max string length is therefore 60
-    if (length > 60) {
+    size_t length = encodeDisplayWriteString(txBuf, COMMAND_DISPLAY_WRITE_HORIZONTAL_STRING, 60, x, y, string, stringLength);
+    if (length == 0) {
       return false;
     }
 
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_DISPLAY_WRITE_HORIZONTAL_STRING;
-    txBuf[2] = length;
-    txBuf[3] = x;
-    txBuf[4] = y;
+    waitUntilReady();
+    send(txBuf, length);
 
-    for (uint8_t i = 0; i < length; i++) {
-      txBuf[i + 5] = string[i];    
-    }
+    return true;
+  }
 
-    send(length + 6);
+  uint16_t Protocol::submitDisplayWriteHorizontalString(uint8_t x, uint8_t y, const String &string, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
 
-    return true;
+    return submit(command, encodeDisplayWriteString(command->buf, COMMAND_DISPLAY_WRITE_HORIZONTAL_STRING, 60, x, y, (const uint8_t *)string.c_str(), string.length()), RESPONSE_LENGTH_NONE, callback, context);
   }
 
   // Write a string verically at the specified position
   bool Protocol::displayWriteVerticalString(uint8_t x, uint8_t y, const String &string) {
-    int length = string.length();
+    return displayWriteVerticalString(x, y, (const uint8_t *)string.c_str(), string.length());
+  }
 
+  bool Protocol::displayWriteVerticalString(uint8_t x, uint8_t y, const uint8_t *string, uint8_t stringLength) {
     // Max buffer must not exceed 65 bytes.  Max string length is therefore 59
-    if (length > 59) {
+    size_t length = encodeDisplayWriteString(txBuf, COMMAND_DISPLAY_WRITE_VERTICAL_STRING, 59, x, y, string, stringLength);
+    if (length == 0) {
       return false;
     }
 
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_DISPLAY_WRITE_VERTICAL_STRING;
-    txBuf[2] = length;
-    txBuf[3] = x;
-    txBuf[4] = y;
+    waitUntilReady();
+    send(txBuf, length);
 
-    for (uint8_t i = 0; i < length; i++) {
-      txBuf[i + 5] = string[i];    
-    }
+    return true;
+  }
 
-    send(length + 6);
+  uint16_t Protocol::submitDisplayWriteVerticalString(uint8_t x, uint8_t y, const String &string, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
 
-    return true;
+    return submit(command, encodeDisplayWriteString(command->buf, COMMAND_DISPLAY_WRITE_VERTICAL_STRING, 59, x, y, (const uint8_t *)string.c_str(), string.length()), RESPONSE_LENGTH_NONE, callback, context);
   }
 
-  // Write chars at the specified positions
-  bool Protocol::displayWriteString(uint8_t x, uint8_t y, uint length, const CharAtPos *charAtPos) {  
+  size_t Protocol::encodeDisplayWriteString(uint8_t *buf, uint length, const CharAtPos *charAtPos) {
     // Max buffer must not exceed 65 bytes.  Max length is therefore 20
     if (length > 20) {
-      return false;
+      return 0;
     }
 
-    txBuf[0] = COMMAND_HEADER;
-    txBuf[1] = COMMAND_DISPLAY_WRITE_STRING;
-    txBuf[2] = length * 3;
+    buf[0] = COMMAND_HEADER;
+    buf[1] = COMMAND_DISPLAY_WRITE_STRING;
+    buf[2] = length * 3;
 
     for (uint8_t i = 0; i < length; i++) {
-      txBuf[i * 3 + 3] = charAtPos[i].x;
-      txBuf[i * 3 + 4] = charAtPos[i].y;
-      txBuf[i * 3 + 5] = charAtPos[i].c;
+      buf[i * 3 + 3] = charAtPos[i].x;
+      buf[i * 3 + 4] = charAtPos[i].y;
+      buf[i * 3 + 5] = charAtPos[i].c;
+    }
+
+    return length * 3 + 4;
+  }
+
+  // Write chars at the specified positions
+  bool Protocol::displayWriteString(uint8_t /* x */, uint8_t /* y */, uint length, const CharAtPos *charAtPos) {  
+    size_t frameLength = encodeDisplayWriteString(txBuf, length, charAtPos);
+    if (frameLength == 0) {
+      return false;
     }
 
-    send(length * 3 + 4);
+    waitUntilReady();
+    send(txBuf, frameLength);
 
     return true;
   }
-}
\ No newline at end of file
+
+  uint16_t Protocol::submitDisplayWriteString(uint length, const CharAtPos *charAtPos, CommandCallbackFuncPtr callback, void *context) {
+    QueuedCommand *command = _queue.reserve();
+    if (command == NULL) {
+      return 0;
+    }
+
+    return submit(command, encodeDisplayWriteString(command->buf, length, charAtPos), RESPONSE_LENGTH_NONE, callback, context);
+  }
+}
@@ -18,17 +18,17 @@
 #define __RUNCAMDRIVER_H__
 
 #include <Arduino.h>
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
 #include <vector>
 #include "Setting.h"
-#include "SettingDetail.h"
-#include "UInt8SettingDetail.h"
-#include "Int8SettingDetail.h"
-#include "UInt16SettingDetail.h"
-#include "Int16SettingDetail.h"
-#include "FloatSettingDetail.h"
-#include "TextSelectionSettingDetail.h"
-#include "StringSettingDetail.h"
-#include "InfoSettingDetail.h"
+#endif
+#include "SettingsStore.h"
+#include "ResponseParser.h"
+#include "CommandQueue.h"
+#include "ProtocolTrace.h"
+#include "ProtocolStats.h"
+#include "RttEstimator.h"
+#include "RunCam_Transport.h"
 
 #define COMMAND_HEADER 0xcc
 
@@ -88,17 +88,20 @@
 #define SETTINGID_DISP_CAMERA_TIME	          6	// STRING	Read and set the camera's time	Read & Write
 
 
-#define SETTING_TYPE_UINT8	         0
-#define SETTING_TYPE_INT8	           1
-#define SETTING_TYPE_UINT16	         2
-#define SETTING_TYPE_INT16	         3
-#define SETTING_TYPE_FLOAT	         8
-#define SETTING_TYPE_TEXT_SELECTION  9
-#define SETTING_TYPE_STRING	        10
-#define SETTING_TYPE_FOLDER	        11
-#define SETTING_TYPE_INFO	          12
-
 #define BUFF_SIZE 65
+#define SETTINGS_CHUNK_MAX_DATA 60          // Largest payload of a setting list or setting detail chunk
+
+#define RESPONSE_TIMEOUT_MS 2000            // Used for every response when adaptive timeouts are off
+
+#define DEFAULT_BAUD_RATE 115200
+#define AUTO_BAUD_RATE 0                    // Detect the camera baud rate while waiting for it to start
+
+#define STARTUP_TIMEOUT_MS 3000             // Upper bound on how long to wait for the camera to answer after reset
+#define STARTUP_PROBE_TIMEOUT_MS 100        // How long to wait for an answer to each readiness probe
+#define STARTUP_PROBE_MIN_BACKOFF_MS 20
+#define STARTUP_PROBE_MAX_BACKOFF_MS 320
+
+#define POLL_DELAY_NONE 0xffffffffUL        // poll() has nothing to do until bytes arrive
 
 namespace RunCam {
 
@@ -111,43 +114,214 @@ namespace RunCam {
   class Protocol {
 
     private:
-      UART* _uart;
+      Transport *_uart;
+      ProtocolTrace *_trace = NULL;
+#ifndef RUNCAM_NO_STATS
+      ProtocolStats _stats;
+      bool _lastFailed = false;
+#endif
       uint8_t txBuf[BUFF_SIZE];
-      uint8_t rxBuf[BUFF_SIZE];
-
-      bool checkCrc(const uint8_t *buf, const uint8_t numBytes);
-      bool checkCrcAndHeader(const uint8_t * buf, const uint8_t numBytes);
+      ResponseParser _parser;
+      unsigned long _requestTime = 0;           // micros() when the response timeout started
+      unsigned long _responseTimeout = RESPONSE_TIMEOUT_MS * 1000UL;
+      uint8_t _responseCommand = 0;             // The request the pending or last response answers
+      uint8_t _detailSettingId = 0;             // Of the last beginReadSettingDetail(), txBuf may be reused
+      uint8_t _responseRequestLength = 0;
+      unsigned long _responseSendTime = 0;
+      RttEstimator _rtt[RESPONSE_COMMAND_COUNT];
+      bool _adaptiveTimeouts = true;
+      CommandQueue _queue;
+      bool _commandInFlight = false;
+
+      bool _ready = false;
+      bool _cameraDetected = false;
+      bool _probeInFlight = false;
+      unsigned long _startTime;
+      unsigned long _startupTime = 0;
+      unsigned long _nextProbeTime;
+      unsigned long _probeBackoff;
+      uint8_t _startupVersion = 0;
+      uint16_t _startupFeatures = 0;
+
+      unsigned long _baudRate = 0;
+      bool _autoBaudRate;
+      bool _baudRateDetected = false;
+      uint8_t _baudRateIndex;
+
+      bool checkResponse();
       void flushRx();
-      int fillRxBuffer(size_t count);
-      int fillRxBuffer(size_t offset, size_t count);
-      void send(size_t length);
+      unsigned long send(uint8_t *buf, size_t length);
+      void responseFinished(uint8_t state);
+      void expectResponse(const uint8_t *request, size_t requestLength, unsigned long sendTime, uint8_t responseLength, uint8_t maxChunkData, unsigned long timeout);
+      void expectResponse(const uint8_t *request, size_t requestLength, unsigned long sendTime, uint8_t responseLength, uint8_t maxChunkData);
+      bool sendRequest(size_t length, uint8_t responseLength, uint8_t maxChunkData = RESPONSE_MAX_CHUNK_DATA);
+      void waitForResponse();
+
+      void setUartBaudRate(unsigned long baudRate);
+      bool probe();
+      void processStartup();
+      void processQueue();
+      void completeCommand(QueuedCommand *command);
+      uint16_t submit(QueuedCommand *command, size_t length, uint8_t responseLength, CommandCallbackFuncPtr callback, void *context, uint8_t maxChunkData = RESPONSE_MAX_CHUNK_DATA);
+
+      size_t encodeReadCameraInfo(uint8_t *buf);
+      size_t encodeCameraControl(uint8_t *buf, uint8_t actionId);
+      size_t encodeFiveKeySimulationPress(uint8_t *buf, uint8_t actionId);
+      size_t encodeFiveKeySimulationRelease(uint8_t *buf);
+      size_t encodeFiveKeySimulationConnection(uint8_t *buf, uint8_t actionId);
+      size_t encodeGetSetting(uint8_t *buf, uint8_t chunkIndex);
+      size_t encodeReadSettingDetail(uint8_t *buf, uint8_t settingId, uint8_t chunkIndex);
+      size_t encodeWriteSetting(uint8_t *buf, uint8_t settingId, uint8_t value);
+      size_t encodeWriteSetting(uint8_t *buf, uint8_t settingId, const String &value);
+      size_t encodeDisplayFillRegion(uint8_t *buf, uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character);
+      size_t encodeDisplayWriteChar(uint8_t *buf, uint8_t x, uint8_t y, uint8_t character);
+      size_t encodeDisplayWriteString(uint8_t *buf, uint8_t command, uint8_t maxLength, uint8_t x, uint8_t y, const uint8_t *string, uint8_t length);
+      size_t encodeDisplayWriteString(uint8_t *buf, uint length, const CharAtPos *charAtPos);
+
+      int parseSettingDetail(const uint8_t *rxBuf, int p, const uint8_t *endPtr, SettingsStore *store, SettingValue *value);
+      int decodeSettings(const uint8_t *rxBuf, SettingsStore *store);
+      int decodeSettingDetails(uint8_t settingId, const uint8_t *rxBuf, SettingsStore *store);
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+      int decodeSettings(const uint8_t *rxBuf, std::vector<RunCam::Setting*> *settings);
+#endif
 
     public:
-      Protocol(UART* uart);
+      static const unsigned long BAUD_RATE_CANDIDATES[];
+      static const uint8_t BAUD_RATE_CANDIDATE_COUNT;
+
+      // The commands the camera replies to, in the order used for per command timeouts and stats
+      static const uint8_t RESPONSE_COMMANDS[RESPONSE_COMMAND_COUNT];
+      static int8_t getResponseCommandIndex(uint8_t command);
+
+      Protocol(Transport *uart, unsigned long baudRate = DEFAULT_BAUD_RATE);
+
+      unsigned long getBaudRate();
+      bool isBaudRateDetected();
+      uint32_t getThroughput();
+      unsigned long detectBaudRate();
+      unsigned long detectBaudRate(const unsigned long *candidates, uint8_t count);
+
+      // Construction does not block.  The camera is probed from poll() until it answers or
+      // STARTUP_TIMEOUT_MS expires.  Blocking calls wait for this to happen first.
+      bool isReady();
+      bool waitUntilReady();
+      unsigned long getStartupTime();
+      bool getStartupCameraInfo(uint8_t *version, uint16_t *features);
+
+      // Record the bytes sent and received, and how each response ended.  NULL stops recording.
+      void setTrace(ProtocolTrace *trace);
+      ProtocolTrace *getTrace();
+
+      // Response timeouts are learned per command from how long the camera takes to answer, kept between the
+      // floor and ceiling, plus the time the bytes take at the current baud rate.  When off every response
+      // gets RESPONSE_TIMEOUT_MS.
+      void setAdaptiveTimeouts(bool adaptiveTimeouts);
+      void setTimeoutLimits(unsigned long floor, unsigned long ceiling);
+      unsigned long getResponseTimeout(uint8_t command, uint8_t requestLength, uint8_t responseLength);
+      unsigned long getWireTime(size_t length);
+      RttEstimator *getRttEstimator(uint8_t command);
+
+#ifndef RUNCAM_NO_STATS
+      // Latency, failure and traffic counts since construction or the last clearStats()
+      const ProtocolStats *getStats();
+      void clearStats();
+#endif
 
       uint8_t calcCrc(const uint8_t *buf, const uint8_t numBytes);
       uint8_t crc8Calc(uint8_t crc, unsigned char a);
 
       typedef void (*GetSettingsCallbackFuncPtr)(uint8_t id, const String &name, const String &value);
 
+      // Blocking interface.  Any queued commands are completed first.  The display writes further down are
+      // the exception.
       bool readCameraInfo(uint8_t *version, uint16_t *features);
       bool cameraControl(uint8_t actionId);
       bool fiveKeySimulationPress(uint8_t actionId);
       bool fiveKeySimulationRelease();
       bool fiveKeySimulationConnection(uint8_t actionId);
 
+      // Settings and details are decoded into a fixed size store.  The settings list can also be decoded
+      // into heap allocated objects unless RUNCAM_NO_DYNAMIC_ALLOCATION is defined.
+      int getSetting(uint8_t chunkIndex, SettingsStore *store);
+      int readSettingDetail(uint8_t settingId, uint8_t chunkIndex, SettingsStore *store);
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
       String getSetting(uint8_t chunkIndex);
       int getSetting(uint8_t chunkIndex, std::vector<RunCam::Setting*> *settings);
-      int readSettingDetail(uint8_t settingId, uint8_t chunkIndex, std::vector<SettingDetail*> *settingDetails);
+#endif
       
-      bool writeSetting(uint8_t settingId, uint8_t value);
-      bool writeSetting(uint8_t settingId, const String &value);
+      // needsRefresh is set when the camera reports that the write changed other settings too
+      bool writeSetting(uint8_t settingId, uint8_t value, bool *needsRefresh = NULL);
+      bool writeSetting(uint8_t settingId, const String &value, bool *needsRefresh = NULL);
 
+      // Display writes have no response and go straight out, ahead of any queued commands and while a
+      // response is pending, so the OSD never waits behind a settings read.  Use the submitDisplay*()
+      // methods to keep them in order with queued commands.
       void displayFillRegion(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character);
       void displayWriteChar(uint8_t x, uint8_t y, uint8_t character);
       bool displayWriteHorizontalString(uint8_t x, uint8_t y, const String &string);
+      bool displayWriteHorizontalString(uint8_t x, uint8_t y, const uint8_t *string, uint8_t length);
       bool displayWriteVerticalString(uint8_t x, uint8_t y, const String &string);
+      bool displayWriteVerticalString(uint8_t x, uint8_t y, const uint8_t *string, uint8_t length);
       bool displayWriteString(uint8_t x, uint8_t y, uint length, const CharAtPos *charAtPos);
+
+      // Non-blocking interface.  A begin method sends the request, poll() is then called until it no longer
+      // returns RESPONSE_PARSER_PENDING and the matching end method decodes the response.  Only one request
+      // can be outstanding at a time; begin methods return false while a response is pending.
+      uint8_t poll();
+      bool isResponsePending();
+
+      // Microseconds until poll() has work to do if no bytes arrive first: a response timing out, the next
+      // startup probe or a queued command to send.  For sleeping in poll(), select() or epoll between calls.
+      unsigned long getPollDelay();
+
+      bool beginReadCameraInfo();
+      bool endReadCameraInfo(uint8_t *version, uint16_t *features);
+
+      bool beginFiveKeySimulationPress(uint8_t actionId);
+      bool beginFiveKeySimulationRelease();
+      bool endFiveKeySimulation();
+
+      bool beginFiveKeySimulationConnection(uint8_t actionId);
+      bool endFiveKeySimulationConnection();
+
+      bool beginGetSetting(uint8_t chunkIndex);
+      int endGetSetting(SettingsStore *store);
+
+      bool beginReadSettingDetail(uint8_t settingId, uint8_t chunkIndex);
+      int endReadSettingDetail(SettingsStore *store);
+
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+      int endGetSetting(std::vector<RunCam::Setting*> *settings);
+#endif
+
+      bool beginWriteSetting(uint8_t settingId, uint8_t value);
+      bool beginWriteSetting(uint8_t settingId, const String &value);
+      bool endWriteSetting(bool *needsRefresh = NULL);
+
+      // Queued interface.  Commands are encoded into a bounded queue and sent in order from poll().  Commands
+      // without a response go out back to back, the rest are sent once the previous response has arrived.
+      // Each returns a handle that is passed back in the CommandResult, or 0 if the queue is full.  Settings
+      // and setting details are decoded into the given store or vector before the callback runs.
+      void flush();
+      uint8_t getQueuedCommandCount();
+
+      uint16_t submitReadCameraInfo(CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitCameraControl(uint8_t actionId, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitFiveKeySimulationPress(uint8_t actionId, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitFiveKeySimulationRelease(CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitFiveKeySimulationConnection(uint8_t actionId, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitGetSetting(uint8_t chunkIndex, SettingsStore *store, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitReadSettingDetail(uint8_t settingId, uint8_t chunkIndex, SettingsStore *store, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+#ifndef RUNCAM_NO_DYNAMIC_ALLOCATION
+      uint16_t submitGetSetting(uint8_t chunkIndex, std::vector<RunCam::Setting*> *settings, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+#endif
+      uint16_t submitWriteSetting(uint8_t settingId, uint8_t value, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitWriteSetting(uint8_t settingId, const String &value, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitDisplayFillRegion(uint8_t x, uint8_t y, uint8_t width, uint8_t height, uint8_t character, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitDisplayWriteChar(uint8_t x, uint8_t y, uint8_t character, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitDisplayWriteHorizontalString(uint8_t x, uint8_t y, const String &string, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitDisplayWriteVerticalString(uint8_t x, uint8_t y, const String &string, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
+      uint16_t submitDisplayWriteString(uint length, const CharAtPos *charAtPos, CommandCallbackFuncPtr callback = NULL, void *context = NULL);
   };
 
 }
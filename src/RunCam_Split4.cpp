@@ -15,194 +15,526 @@
  */
 
 #include "RunCam_Split4.h"
-#include "TextSelectionSettingDetail.h"
+#include "OsdFrameBuffer.h"
 
 namespace RunCam {
 
-  Split4::Split4(UART *uart) {
-    _driver = new Protocol(uart);
-  
-    if (!_driver->readCameraInfo(&_version, &_features)) {
+  // The settings a captured profile holds, in the order they are written
+  static const uint8_t PROFILE_SETTINGS[] = { SETTINGID_DISP_CHARSET, SETTINGID_DISP_TV_MODE, SETTINGID_DISP_RESOLUTION };
+
+  struct ProfileWrite {
+    const ProfileEntry *entry;
+    bool success;
+    bool refresh;
+  };
+
+  static void profileWriteDone(const CommandResult &result, void *context) {
+    ProfileWrite *write = (ProfileWrite *)context;
+    write->success = result.success;
+    write->refresh = result.refresh != 0;
+  }
+
+  static void profileReadDone(const CommandResult &result, void *context) {
+    *(int *)context = result.success ? result.remainingChunks : -1;
+  }
+
+  Split4::Split4(Transport *uart, unsigned long baudRate, SettingsCacheStorage *cache, uint8_t settingsMode) : _driver(uart, baudRate) {
+    _cache = cache;
+    _warmStart = false;
+
+    // Only these change without being written
+    for (int i = 0; i < SPLIT4_SETTING_COUNT; i++) {
+      _ttl[i] = SETTING_TTL_FOREVER;
+    }
+    _ttl[SETTINGID_DISP_SDCARD_CAPACITY] = SETTING_TTL_VOLATILE_MS;
+    _ttl[SETTINGID_DISP_REMAIN_RECORDING_TIME] = SETTING_TTL_VOLATILE_MS;
+    _ttl[SETTINGID_DISP_CAMERA_TIME] = SETTING_TTL_VOLATILE_MS;
+
+    // Returns as soon as the camera answers, which also gives us its info without another round trip
+    _driver.waitUntilReady();
+
+    if (!_driver.getStartupCameraInfo(&_version, &_features) && !_driver.readCameraInfo(&_version, &_features)) {
       _version = 0;
       _features = 0;
     }
 
-    refreshSettings();
+    // In lazy mode findSetting() reads each setting on first use
+    _warmStart = loadSettingsCache();
+    if (!_warmStart && settingsMode == SPLIT4_SETTINGS_EAGER) {
+      refreshSettings();
+    } else {
+      publishSettings();
+    }
+  }
+
+  bool Split4::isWarmStart() {
+    return _warmStart;
+  }
+
+  // The cache is only valid for the firmware and features it was read from
+  uint32_t Split4::getCacheKey() {
+    return (uint32_t)_version << 16 | _features;
+  }
+
+  bool Split4::loadSettingsCache() {
+    if (_cache == NULL || !(_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS)) {
+      return false;
+    }
+
+    if (!_settings.load(_cache, getCacheKey())) {
+      return false;
+    }
+
+    // Settings that only change when written are as good as new.  The rest stay stale so their first use
+    // reads them from the camera.
+    for (uint8_t i = 0; i < _settings.getCount(); i++) {
+      SettingRecord *record = _settings.get(i);
+      if (getSettingTtl(record->id) == SETTING_TTL_FOREVER) {
+        record->stale = false;
+        record->updateTime = millis();
+      }
+    }
+
+    return true;
+  }
+
+  bool Split4::saveSettingsCache() {
+    if (_cache == NULL || !(_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS)) {
+      return false;
+    }
+
+    return _settings.save(_cache, getCacheKey());
+  }
+
+  // Milliseconds from construction until the camera answered
+  unsigned long Split4::getStartupTime() {
+    return _driver.getStartupTime();
+  }
+
+  // For direct access to the display commands
+  Protocol *Split4::getProtocol() {
+    return &_driver;
+  }
+
+  SettingsStore *Split4::getSettings() {
+    return &_settings;
+  }
+
+  // Readers keep using the last copy if every other one is held, the next change publishes again
+  void Split4::publishSettings() {
+#ifdef RUNCAM_HAS_ATOMIC
+    _publisher.publish(&_settings);
+#endif
   }
-  
-  Split4::~Split4() {
-    delete _driver;
+
+#ifdef RUNCAM_HAS_ATOMIC
+  SettingsSnapshot *Split4::acquireSettings() {
+    return _publisher.acquire();
+  }
+
+  void Split4::releaseSettings(SettingsSnapshot *snapshot) {
+    _publisher.release(snapshot);
   }
+#endif
 
   uint8_t Split4::getVersion() {
     return _version;
   }
 
+  // Settings are updated in place, so a refresh only takes more of the store for settings or values
+  // longer than any seen before.  Values from a failed refresh are left as they were.
   void Split4::refreshSettings() {
-    _settings.clear();
-    _settingDetails.clear();
-
     if (_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS) {
       int remainingChunks;
-      int i;
+      int i = 0;
       do {
-        remainingChunks = _driver->getSetting(i++, &_settings);
+        remainingChunks = _driver.getSetting(i++, &_settings);
       } while (remainingChunks > 0);
       
-      for (int i = 0; i < 7; i++) {
-        remainingChunks = 0;
-        do {
-          remainingChunks = _driver->readSettingDetail(i, remainingChunks, &_settingDetails);
-        } while (remainingChunks > 0);
+      for (int i = 0; i < SPLIT4_SETTING_COUNT; i++) {
+        readDetail(i);
       }
+
+      // Every record has just been rewritten, so drop what the values that grew left behind
+      _settings.compact();
+      saveSettingsCache();
+      publishSettings();
     }
   }
 
-  bool Split4::pressWiFiButton() {
-    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_SIMULATE_WIFI_BUTTON)) {
+  bool Split4::readDetail(uint8_t settingId) {
+    int remainingChunks;
+    int i = 0;
+    do {
+      remainingChunks = _driver.readSettingDetail(settingId, i++, &_settings);
+    } while (remainingChunks > 0);
+
+    return remainingChunks == 0;
+  }
+
+  bool Split4::refresh(uint8_t settingId) {
+    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS)) {
       return false;
     }
 
-    return _driver->cameraControl(RCDEVICE_PROTOCOL_SIMULATE_WIFI_BTN);
+    bool success = readDetail(settingId);
+    publishSettings();
+    return success;
   }
 
-  bool Split4::pressPowerButton() {
-    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_SIMULATE_POWER_BUTTON)) {
-      return false;
+  // Readers of snapshots see the setting go stale too
+  void Split4::invalidate(uint8_t settingId) {
+    _settings.invalidate(settingId);
+    publishSettings();
+  }
+
+  void Split4::setSettingTtl(uint8_t settingId, unsigned long ttl) {
+    if (settingId < SPLIT4_SETTING_COUNT) {
+      _ttl[settingId] = ttl;
+    }
+  }
+
+  unsigned long Split4::getSettingTtl(uint8_t settingId) {
+    if (settingId >= SPLIT4_SETTING_COUNT) {
+      return SETTING_TTL_FOREVER;
     }
 
-    return _driver->cameraControl(RCDEVICE_PROTOCOL_SIMULATE_POWER_BTN);
+    return _ttl[settingId];
   }
 
-  bool Split4::toggleMode() {
-    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_SIMULATE_POWER_BUTTON)) {
-      return false;
+  // A write changes the written setting.  The camera flags when it changed others too, e.g. the
+  // resolutions on offer depend on the TV mode.
+  void Split4::settingWritten(uint8_t settingId, bool needsRefresh) {
+    if (needsRefresh) {
+      _settings.invalidateAll();
+    } else {
+      _settings.invalidate(settingId);
+    }
+
+    // Read the changes now rather than on next use so the cache doesn't keep the old values
+    if (_cache != NULL) {
+      if (needsRefresh) {
+        refreshSettings();
+        return;
+      }
+
+      if (readDetail(settingId)) {
+        saveSettingsCache();
+      }
     }
 
-    return _driver->cameraControl(RCDEVICE_PROTOCOL_CHANGE_MODE);
+    publishSettings();
   }
 
-  String Split4::getCharset() {
+  // Returns the setting, reading it first if it hasn't been read yet, is stale or has outlived its TTL
+  SettingRecord *Split4::findSetting(uint8_t settingId) {
     if (!(_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS)) {
-      return "";
+      return NULL;
     }
 
-    for (int i = 0; i < _settings.size(); i++){
-      int value = _settings[SETTINGID_DISP_CHARSET]->getValue().toInt();
+    SettingRecord *record = _settings.find(settingId);
+
+    unsigned long ttl = getSettingTtl(settingId);
+    if (record == NULL || record->stale || (ttl != SETTING_TTL_FOREVER && millis() - record->updateTime >= ttl)) {
+      readDetail(settingId);
+      publishSettings();
+      record = _settings.find(settingId);
+    }
 
-      TextSelectionSettingDetail* detail = (TextSelectionSettingDetail*)_settingDetails[SETTINGID_DISP_CHARSET];
-      std::vector<arduino::String*>* selection = detail->getTextSelection();
+    return record;
+  }
 
-      return *selection->at(value);
+  // The current value as text.  String and info settings are read from their detail, which refresh()
+  // keeps up to date, otherwise the value from the settings list is used.
+  String Split4::getSettingValue(uint8_t settingId) {
+    SettingRecord *record = findSetting(settingId);
+    if (record == NULL) {
+      return "";
     }
 
-    return "";
+    if (record->detail.asString() != NULL || record->detail.asInfo() != NULL) {
+      return String(_settings.getText(record));
+    }
+
+    return String(_settings.getValue(record));
   }
 
-  // v2.0.1 & v2.0.4 of the firmware reports these values.
-  // 3840x2160P30 -> (0) 1080P60FPS
-  // 2704x1520P60 -> (1) 1080P50FPS
-  // 2704x1520P50 -> (2) 1080P30FPS
-  // 1920x1080P60 -> (3) 720P60FPS
-  // 1920x1080P50 -> (4) ?
-  String Split4::getResolution() {
-    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS)) {
+  // The text of the selected option of a TEXT_SELECTION setting, "?" if the selection is out of range
+  String Split4::getSelectedOption(uint8_t settingId) {
+    SettingRecord *record = findSetting(settingId);
+    if (record == NULL || record->detail.asTextSelection() == NULL) {
       return "";
     }
 
-    for (int i = 0; i < _settings.size(); i++){
-      TextSelectionSettingDetail* detail = (TextSelectionSettingDetail*)_settingDetails[SETTINGID_DISP_RESOLUTION];
-      std::vector<arduino::String*>* selection = detail->getTextSelection();
+    const char *option = _settings.getOption(record, record->detail.asTextSelection()->value);
+    if (option == NULL) {
+      return "?";
+    }
 
-      int value = detail->getValue();
+    return String(option);
+  }
 
+  // Text selections are written as the index of the option
+  bool Split4::setSelectedOption(uint8_t settingId, const String &option) {
+    SettingRecord *record = findSetting(settingId);
+    if (record == NULL) {
+      return false;
+    }
 
-      if (value >= selection->size()) {
-        return "?";
-      }
+    const TextSelectionValue *selection = record->detail.asTextSelection();
+    if (selection == NULL) {
+      return false;
+    }
+
+    for (int i = 0; i < selection->optionCount; i++) {
+      if (option == _settings.getOption(record, i)) {
+        bool needsRefresh = false;
+        if (!_driver.writeSetting(settingId, i, &needsRefresh)) {
+          return false;
+        }
 
-      return *selection->at(value);
+        settingWritten(settingId, needsRefresh);
+        return true;
+      }
     }
 
-    return "";
+    return false;
   }
 
-  bool Split4::setResolution(const String &resolution) {
-    return _driver->writeSetting(SETTINGID_DISP_RESOLUTION, resolution);
+  uint8_t Split4::captureProfile(SettingsProfile *profile) {
+    for (uint8_t i = 0; i < sizeof(PROFILE_SETTINGS); i++) {
+      findSetting(PROFILE_SETTINGS[i]);
+    }
+
+    return profile->capture(&_settings, PROFILE_SETTINGS, sizeof(PROFILE_SETTINGS));
   }
 
-  int Split4::getDisplayColumns() {
+  bool Split4::applyProfile(SettingsProfile *profile, ProfileApplyReport *report) {
+    ProfileApplyReport unused;
+    if (report == NULL) {
+      report = &unused;
+    }
+    memset(report, 0, sizeof(ProfileApplyReport));
+
     if (!(_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS)) {
-      return -1;
+      return false;
+    }
+
+    unsigned long startTime = micros();
+
+    // Settings that have not been read, or are stale, are written without comparing
+    ProfileWrite writes[SETTINGS_PROFILE_MAX_ENTRIES];
+    uint8_t writeCount = 0;
+    for (uint8_t i = 0; i < profile->getCount(); i++) {
+      const ProfileEntry *entry = profile->get(i);
+      SettingRecord *record = _settings.find(entry->settingId);
+      if (record != NULL && !record->stale && SettingsProfile::matches(entry, &_settings, record)) {
+        report->unchanged++;
+        continue;
+      }
+
+      ProfileWrite *write = &writes[writeCount];
+      write->entry = entry;
+      write->success = false;
+      write->refresh = false;
+
+      if (_driver.getQueuedCommandCount() == COMMAND_QUEUE_SIZE) {
+        _driver.flush();
+      }
+
+      uint16_t handle;
+      if (entry->isText) {
+        handle = _driver.submitWriteSetting(entry->settingId, String(entry->text), profileWriteDone, write);
+      } else {
+        handle = _driver.submitWriteSetting(entry->settingId, entry->value, profileWriteDone, write);
+      }
+
+      if (handle != 0) {
+        writeCount++;
+      } else {
+        report->failed++;
+      }
     }
 
-    for (size_t i = 0; i < _settings.size(); i++){
-      return _settings[SETTINGID_DISP_COLUMNS]->getValue().toInt();
+    _driver.flush();
+
+    bool refresh = false;
+    for (uint8_t i = 0; i < writeCount; i++) {
+      if (writes[i].success) {
+        report->written++;
+        refresh = refresh || writes[i].refresh;
+      } else {
+        report->failed++;
+      }
     }
 
-    return -1;
-  }
+    if (refresh) {
+      report->reread = rereadSettings();
+    }
 
-  String Split4::getDisplayMode() {
-    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS)) {
-      return "";
+    // What was read back is what the camera holds, otherwise use what was written
+    for (uint8_t i = 0; i < writeCount; i++) {
+      SettingRecord *record = _settings.find(writes[i].entry->settingId);
+      if (!writes[i].success) {
+        _settings.invalidate(writes[i].entry->settingId);
+      } else if (!refresh || (record != NULL && record->stale)) {
+        settingApplied(writes[i].entry);
+      }
     }
 
-    for (int i = 0; i < _settings.size(); i++){
-      int value = _settings[SETTINGID_DISP_TV_MODE]->getValue().toInt();
+    if (writeCount > 0) {
+      saveSettingsCache();
+      publishSettings();
+    }
 
-      TextSelectionSettingDetail* detail = (TextSelectionSettingDetail*)_settingDetails[SETTINGID_DISP_TV_MODE];
-      std::vector<arduino::String*>* selection = detail->getTextSelection();
+    report->time = micros() - startTime;
+    return report->failed == 0;
+  }
 
-      value = detail->getValue();
+  // The camera accepted the value, so it goes into the cache as if it had been read back
+  void Split4::settingApplied(const ProfileEntry *entry) {
+    SettingRecord *record = _settings.find(entry->settingId);
+    if (record == NULL) {
+      return;
+    }
 
-      return *selection->at(value);
+    const TextSelectionValue *selection = record->detail.asTextSelection();
+    const UInt8Value *uint8 = record->detail.asUInt8();
+    const StringValue *string = record->detail.asString();
+
+    if (entry->isText && string != NULL) {
+      uint16_t offset = _settings.setString(string->textOffset, (const uint8_t *)entry->text, strlen(entry->text));
+      // The old text may have been squeezed out of the pool, so don't leave the detail pointing at it
+      record->detail.setString(offset, string->maxStringSize);
+      if (offset == SETTINGS_STORE_NO_STRING) {
+        _settings.invalidate(entry->settingId);
+        return;
+      }
+    } else if (!entry->isText && selection != NULL && entry->value < selection->optionCount) {
+      record->detail.setTextSelection(entry->value, selection->optionCount, selection->textOffset);
+    } else if (!entry->isText && uint8 != NULL) {
+      record->detail.setUInt8(entry->value, uint8->min, uint8->max, uint8->stepSize);
+    } else {
+      _settings.invalidate(entry->settingId);
+      return;
     }
 
-    return "";
+    record->stale = false;
+    record->updateTime = millis();
   }
 
-  bool Split4::setDisplayMode(const String &displayMode) {    
-    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS)) {
-      return false;
+  // After a write changed other settings.  Those that only change when written are read again now, the
+  // first chunk of each back to back and any that need more one at a time.  The rest have a TTL, so they
+  // are left stale for the getters to read on next use.  Returns how many were read.
+  uint8_t Split4::rereadSettings() {
+    _settings.invalidateAll();
+
+    uint8_t ids[SETTINGS_STORE_MAX_SETTINGS];
+    int remainingChunks[SETTINGS_STORE_MAX_SETTINGS];
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < _settings.getCount(); i++) {
+      uint8_t settingId = _settings.get(i)->id;
+      if (getSettingTtl(settingId) != SETTING_TTL_FOREVER) {
+        continue;
+      }
+
+      if (_driver.getQueuedCommandCount() == COMMAND_QUEUE_SIZE) {
+        _driver.flush();
+      }
+
+      ids[count] = settingId;
+      remainingChunks[count] = -1;
+      _driver.submitReadSettingDetail(settingId, 0, &_settings, profileReadDone, &remainingChunks[count]);
+      count++;
     }
 
-    TextSelectionSettingDetail* detail = (TextSelectionSettingDetail*)_settingDetails.at(SETTINGID_DISP_TV_MODE);
-    std::vector<arduino::String*>* selection = detail->getTextSelection();
+    _driver.flush();
 
-    for (int i = 0; i < selection->size(); i++) {
-      if (*(selection->at(i)) == displayMode) {
-        return _driver->writeSetting(SETTINGID_DISP_TV_MODE, i);
+    for (uint8_t i = 0; i < count; i++) {
+      if (remainingChunks[i] > 0) {
+        readDetail(ids[i]);
       }
     }
 
-    return false;
+    return count;
   }
 
-  // Reports "0/3" if there is no SD card
-  String Split4::getSdCapacity() {
-    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_DEVICE_SETTINGS_ACCESS)) {
-      return "";
+  bool Split4::pressWiFiButton() {
+    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_SIMULATE_WIFI_BUTTON)) {
+      return false;
     }
 
-    for (int i = 0; i < _settings.size(); i++){
-      return _settings[SETTINGID_DISP_SDCARD_CAPACITY]->getValue();
+    return _driver.cameraControl(RCDEVICE_PROTOCOL_SIMULATE_WIFI_BTN);
+  }
+
+  bool Split4::pressPowerButton() {
+    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_SIMULATE_POWER_BUTTON)) {
+      return false;
     }
 
-    return "";
+    return _driver.cameraControl(RCDEVICE_PROTOCOL_SIMULATE_POWER_BTN);
   }
 
-  // Reports "0/3" if there is no SD card
-  String Split4::getRemainingRecordingTime() {
-    if (!(_features & SETTINGID_DISP_REMAIN_RECORDING_TIME)) {
-      return "";
+  bool Split4::toggleMode() {
+    if (!(_features & RCDEVICE_PROTOCOL_FEATURE_SIMULATE_POWER_BUTTON)) {
+      return false;
     }
 
-    for (int i = 0; i < _settings.size(); i++){
-      return _settings[SETTINGID_DISP_SDCARD_CAPACITY]->getValue();
+    return _driver.cameraControl(RCDEVICE_PROTOCOL_CHANGE_MODE);
+  }
+
+  String Split4::getCharset() {
+    return getSelectedOption(SETTINGID_DISP_CHARSET);
+  }
+
+  // v2.0.1 & v2.0.4 of the firmware reports these values.
+  // 3840x2160P30 -> (0) 1080P60FPS
+  // 2704x1520P60 -> (1) 1080P50FPS
+  // 2704x1520P50 -> (2) 1080P30FPS
+  // 1920x1080P60 -> (3) 720P60FPS
+  // 1920x1080P50 -> (4) ?
+  String Split4::getResolution() {
+    return getSelectedOption(SETTINGID_DISP_RESOLUTION);
+  }
+
+  bool Split4::setResolution(const String &resolution) {
+    return setSelectedOption(SETTINGID_DISP_RESOLUTION, resolution);
+  }
+
+  int Split4::getDisplayColumns() {
+    SettingRecord *record = findSetting(SETTINGID_DISP_COLUMNS);
+    if (record == NULL) {
+      return -1;
     }
 
-    return "";
+    int32_t columns;
+    if (record->detail.getInteger(&columns)) {
+      return columns;
+    }
+
+    return atoi(_settings.getValue(record));
+  }
+
+  String Split4::getDisplayMode() {
+    return getSelectedOption(SETTINGID_DISP_TV_MODE);
+  }
+
+  // Rows of OSD characters for the current TV mode
+  int Split4::getDisplayRows() {
+    return OsdFrameBuffer::getRowCount(getDisplayMode());
+  }
+
+  bool Split4::setDisplayMode(const String &displayMode) {    
+    return setSelectedOption(SETTINGID_DISP_TV_MODE, displayMode);
+  }
+
+  // Reports "0/3" if there is no SD card
+  String Split4::getSdCapacity() {
+    return getSettingValue(SETTINGID_DISP_SDCARD_CAPACITY);
+  }
+
+  String Split4::getRemainingRecordingTime() {
+    return getSettingValue(SETTINGID_DISP_REMAIN_RECORDING_TIME);
   }
 
   bool Split4::hasSdCard() {
@@ -210,18 +542,16 @@ namespace RunCam {
   }
 
   String Split4::getCameraTime() {
-    if (!(_features & SETTINGID_DISP_REMAIN_RECORDING_TIME)) {
-      return "";
-    }
+    return getSettingValue(SETTINGID_DISP_CAMERA_TIME);
+  }
 
-    for (int i = 0; i < _settings.size(); i++){
-      return _settings[SETTINGID_DISP_CAMERA_TIME]->getValue();
+  bool Split4::setCameraTime(const String &time) {
+    bool needsRefresh = false;
+    if (!_driver.writeSetting(SETTINGID_DISP_CAMERA_TIME, time, &needsRefresh)) {
+      return false;
     }
 
-    return "";
-  }
-
-  bool Split4::setCameraTime(const String &resolution) {
-    return _driver->writeSetting(SETTINGID_DISP_CAMERA_TIME, resolution);
+    settingWritten(SETTINGID_DISP_CAMERA_TIME, needsRefresh);
+    return true;
   }
 }
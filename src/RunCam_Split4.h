@@ -18,25 +18,107 @@
 #define __RUNCAM_SPLIT4_H__
 
 #include "RunCam_Protocol.h"
+#include "SettingsSnapshot.h"
+#include "SettingsProfile.h"
+
+#define SPLIT4_SETTING_COUNT 7                // SETTINGID_DISP_CHARSET to SETTINGID_DISP_CAMERA_TIME
+
+#define SPLIT4_SETTINGS_EAGER 0               // Read every setting when constructed
+#define SPLIT4_SETTINGS_LAZY 1                // Read each setting the first time a getter needs it
+
+#define SETTING_TTL_FOREVER 0xffffffff        // Only read again after a write or invalidate()
+#define SETTING_TTL_VOLATILE_MS 1000          // SD capacity, remaining recording time and camera time
 
 namespace RunCam {
 
+  struct ProfileApplyReport {
+    uint8_t unchanged;                        // Already held the profile's value, so not written
+    uint8_t written;
+    uint8_t failed;                           // Rejected by the camera or not answered
+    uint8_t reread;                           // Details read again because a write changed other settings
+    unsigned long time;                       // Microseconds for the whole apply
+  };
+
   class Split4 {
     private:
-      RunCam::Protocol *_driver;
+      RunCam::Protocol _driver;
       uint8_t _version;
       uint16_t _features;
-      std::vector<RunCam::Setting*> _settings = std::vector<RunCam::Setting*>();
-      std::vector<RunCam::SettingDetail*> _settingDetails = std::vector<RunCam::SettingDetail*>();
+      SettingsStore _settings;
+      unsigned long _ttl[SPLIT4_SETTING_COUNT];
+      SettingsCacheStorage *_cache;
+      bool _warmStart;
+#ifdef RUNCAM_HAS_ATOMIC
+      SettingsPublisher _publisher;
+#endif
+
+      uint32_t getCacheKey();
+      bool loadSettingsCache();
+      bool readDetail(uint8_t settingId);
+      void settingWritten(uint8_t settingId, bool needsRefresh);
+      SettingRecord *findSetting(uint8_t settingId);
+      String getSettingValue(uint8_t settingId);
+      String getSelectedOption(uint8_t settingId);
+      bool setSelectedOption(uint8_t settingId, const String &option);
+      void publishSettings();
+      void settingApplied(const ProfileEntry *entry);
+      uint8_t rereadSettings();
 
     public:
-      Split4(UART *uart);
-      ~Split4();
+      // With a cache the settings read from the camera are saved to it.  Later starts with the same firmware
+      // and features load them from the cache instead of reading them all again.  Apps that only use a few
+      // settings, or none, can pass SPLIT4_SETTINGS_LAZY to skip reading them all up front.
+      //
+      // Unlike Protocol's, this constructor blocks.  It waits for the camera to answer, up to
+      // STARTUP_TIMEOUT_MS, and in eager mode without a usable cache it then reads every setting before
+      // returning.  Construct it in setup() or on a task that may block, never at global scope.  Code that
+      // must keep running meanwhile should drive a Protocol with poll() and the queued interface instead.
+      Split4(Transport *uart, unsigned long baudRate = DEFAULT_BAUD_RATE, SettingsCacheStorage *cache = NULL, uint8_t settingsMode = SPLIT4_SETTINGS_EAGER);
+
+      Protocol *getProtocol();
+
+      // The settings read by the last refresh, and the memory they use.  Only for the thread driving the
+      // Split4, the same as every other method except the snapshot ones.
+      SettingsStore *getSettings();
+
+#ifdef RUNCAM_HAS_ATOMIC
+      // For other threads.  Each refresh, lazy read and write publishes a copy of the settings, which
+      // readers can hold without locking and without seeing a refresh half done.  NULL until the first
+      // publish.  Release each snapshot once read.
+      SettingsSnapshot *acquireSettings();
+      void releaseSettings(SettingsSnapshot *snapshot);
+#endif
 
       uint8_t getVersion();
 
+      unsigned long getStartupTime();
+
+      // True if the settings came from the cache at startup
+      bool isWarmStart();
+      bool saveSettingsCache();
+
+      // Reads every setting and detail
       void refreshSettings();
 
+      // Reads the detail of one setting.  Getters call this themselves when their setting is stale or older
+      // than its TTL, so it only needs calling directly to force a read.
+      bool refresh(uint8_t settingId);
+      void invalidate(uint8_t settingId);
+
+      // How long a setting is used before the getters read it again
+      void setSettingTtl(uint8_t settingId, unsigned long ttl);
+      unsigned long getSettingTtl(uint8_t settingId);
+
+      // Captures the charset, TV mode and resolution, reading any not read yet.  Add the camera time to the
+      // profile with setText() before applying it, a captured time would be out of date.
+      uint8_t captureProfile(SettingsProfile *profile);
+
+      // Writes only the profile's values that differ from the cached settings, back to back through the
+      // command queue.  Written values go straight into the cache.  Details are only read again if a write
+      // response says other settings changed, and then only those without a TTL.  Returns false if any
+      // write failed.
+      bool applyProfile(SettingsProfile *profile, ProfileApplyReport *report = NULL);
+
       bool pressWiFiButton();
 
       bool pressPowerButton();
@@ -50,6 +132,8 @@ namespace RunCam {
 
       int getDisplayColumns();
 
+      int getDisplayRows();
+
       String getDisplayMode();
       bool setDisplayMode(const String &displayMode);
 
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __RUNCAM_TRANSPORT_H__
+#define __RUNCAM_TRANSPORT_H__
+
+#include <Arduino.h>
+#include "LoopbackTransport.h"
+#include "TermiosTransport.h"
+
+// The byte stream Protocol and Split4 talk to the camera over.  It is fixed at compile time so that the
+// hot paths (send, poll and the blocking waits) make direct calls into it.  The default is any
+// HardwareSerial, which covers the board UARTs and SimulatedCamera.  HardwareSerial and the cores' UART
+// classes derived from it are not final, so on a board every call still goes through their vtable.  Define
+// RUNCAM_TRANSPORT as one of the final classes below to have the compiler bind and inline the calls
+// instead; both are host only:
+//
+//   LoopbackTransport  An in-memory pair, one end for Protocol and one for whatever plays the camera
+//   TermiosTransport   A serial port or pseudo-terminal on Linux
+//
+// Any other class works as long as it has begin(baudRate, config), end(), available(), read() and
+// write(buffer, length).  Time comes from millis() and micros(), which the host build in src/host provides
+// when there is no Arduino core.
+//
+// RUNCAM_TRANSPORT must be the same in every translation unit, so set it as a global build flag (-D on the
+// compiler command line or in build_flags), not with a #define in a sketch.  Classes such as Protocol
+// change layout with it, and mixing two definitions in one program breaks the one definition rule.
+#ifndef RUNCAM_TRANSPORT
+#define RUNCAM_TRANSPORT HardwareSerial
+#endif
+
+namespace RunCam {
+
+  typedef RUNCAM_TRANSPORT Transport;
+
+}
+
+#endif // __RUNCAM_TRANSPORT_H__
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SettingValue.h"
+
+namespace RunCam {
+
+  SettingValue::SettingValue() {
+    clear();
+  }
+
+  uint8_t SettingValue::getType() const {
+    return _type;
+  }
+
+  bool SettingValue::isEmpty() const {
+    return _type == SETTING_TYPE_NONE;
+  }
+
+  void SettingValue::clear() {
+    _type = SETTING_TYPE_NONE;
+    memset(&_data, 0, sizeof(_data));
+  }
+
+  void SettingValue::setUInt8(uint8_t value, uint8_t min, uint8_t max, uint8_t stepSize) {
+    _type = SETTING_TYPE_UINT8;
+    _data.uint8.value = value;
+    _data.uint8.min = min;
+    _data.uint8.max = max;
+    _data.uint8.stepSize = stepSize;
+  }
+
+  void SettingValue::setInt8(int8_t value, int8_t min, int8_t max, int8_t stepSize) {
+    _type = SETTING_TYPE_INT8;
+    _data.int8.value = value;
+    _data.int8.min = min;
+    _data.int8.max = max;
+    _data.int8.stepSize = stepSize;
+  }
+
+  void SettingValue::setUInt16(uint16_t value, uint16_t min, uint16_t max, uint16_t stepSize) {
+    _type = SETTING_TYPE_UINT16;
+    _data.uint16.value = value;
+    _data.uint16.min = min;
+    _data.uint16.max = max;
+    _data.uint16.stepSize = stepSize;
+  }
+
+  void SettingValue::setInt16(int16_t value, int16_t min, int16_t max, int16_t stepSize) {
+    _type = SETTING_TYPE_INT16;
+    _data.int16.value = value;
+    _data.int16.min = min;
+    _data.int16.max = max;
+    _data.int16.stepSize = stepSize;
+  }
+
+  void SettingValue::setFloat(int32_t value, int32_t min, int32_t max, int16_t decimalPoint, int32_t stepSize) {
+    _type = SETTING_TYPE_FLOAT;
+    _data.float32.value = value;
+    _data.float32.min = min;
+    _data.float32.max = max;
+    _data.float32.decimalPoint = decimalPoint;
+    _data.float32.stepSize = stepSize;
+  }
+
+  void SettingValue::setTextSelection(uint8_t value, uint8_t optionCount, uint16_t textOffset) {
+    _type = SETTING_TYPE_TEXT_SELECTION;
+    _data.textSelection.value = value;
+    _data.textSelection.optionCount = optionCount;
+    _data.textSelection.textOffset = textOffset;
+  }
+
+  void SettingValue::setString(uint16_t textOffset, uint8_t maxStringSize) {
+    _type = SETTING_TYPE_STRING;
+    _data.string.textOffset = textOffset;
+    _data.string.maxStringSize = maxStringSize;
+  }
+
+  void SettingValue::setInfo(uint16_t textOffset) {
+    _type = SETTING_TYPE_INFO;
+    _data.info.textOffset = textOffset;
+  }
+
+  const UInt8Value *SettingValue::asUInt8() const {
+    return _type == SETTING_TYPE_UINT8 ? &_data.uint8 : NULL;
+  }
+
+  const Int8Value *SettingValue::asInt8() const {
+    return _type == SETTING_TYPE_INT8 ? &_data.int8 : NULL;
+  }
+
+  const UInt16Value *SettingValue::asUInt16() const {
+    return _type == SETTING_TYPE_UINT16 ? &_data.uint16 : NULL;
+  }
+
+  const Int16Value *SettingValue::asInt16() const {
+    return _type == SETTING_TYPE_INT16 ? &_data.int16 : NULL;
+  }
+
+  const FloatValue *SettingValue::asFloat() const {
+    return _type == SETTING_TYPE_FLOAT ? &_data.float32 : NULL;
+  }
+
+  const TextSelectionValue *SettingValue::asTextSelection() const {
+    return _type == SETTING_TYPE_TEXT_SELECTION ? &_data.textSelection : NULL;
+  }
+
+  const StringValue *SettingValue::asString() const {
+    return _type == SETTING_TYPE_STRING ? &_data.string : NULL;
+  }
+
+  const InfoValue *SettingValue::asInfo() const {
+    return _type == SETTING_TYPE_INFO ? &_data.info : NULL;
+  }
+
+  bool SettingValue::getInteger(int32_t *value) const {
+    switch (_type) {
+      case SETTING_TYPE_UINT8:
+        *value = _data.uint8.value;
+        return true;
+
+      case SETTING_TYPE_INT8:
+        *value = _data.int8.value;
+        return true;
+
+      case SETTING_TYPE_UINT16:
+        *value = _data.uint16.value;
+        return true;
+
+      case SETTING_TYPE_INT16:
+        *value = _data.int16.value;
+        return true;
+
+      case SETTING_TYPE_FLOAT:
+        *value = _data.float32.value;
+        return true;
+
+      case SETTING_TYPE_TEXT_SELECTION:
+        *value = _data.textSelection.value;
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+  uint16_t SettingValue::getTextOffset() const {
+    switch (_type) {
+      case SETTING_TYPE_TEXT_SELECTION:
+        return _data.textSelection.textOffset;
+
+      case SETTING_TYPE_STRING:
+        return _data.string.textOffset;
+
+      case SETTING_TYPE_INFO:
+        return _data.info.textOffset;
+
+      default:
+        return SETTING_VALUE_NO_TEXT;
+    }
+  }
+
+  void SettingValue::setTextOffset(uint16_t textOffset) {
+    switch (_type) {
+      case SETTING_TYPE_TEXT_SELECTION:
+        _data.textSelection.textOffset = textOffset;
+        break;
+
+      case SETTING_TYPE_STRING:
+        _data.string.textOffset = textOffset;
+        break;
+
+      case SETTING_TYPE_INFO:
+        _data.info.textOffset = textOffset;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  void SettingValue::accept(uint8_t settingId, const char *pool, SettingValueVisitor *visitor) const {
+    uint16_t textOffset = getTextOffset();
+    const char *text = textOffset == SETTING_VALUE_NO_TEXT ? "" : &pool[textOffset];
+
+    switch (_type) {
+      case SETTING_TYPE_UINT8:
+        visitor->visit(settingId, _data.uint8);
+        break;
+
+      case SETTING_TYPE_INT8:
+        visitor->visit(settingId, _data.int8);
+        break;
+
+      case SETTING_TYPE_UINT16:
+        visitor->visit(settingId, _data.uint16);
+        break;
+
+      case SETTING_TYPE_INT16:
+        visitor->visit(settingId, _data.int16);
+        break;
+
+      case SETTING_TYPE_FLOAT:
+        visitor->visit(settingId, _data.float32);
+        break;
+
+      case SETTING_TYPE_TEXT_SELECTION:
+        visitor->visit(settingId, _data.textSelection, text);
+        break;
+
+      case SETTING_TYPE_STRING:
+        visitor->visit(settingId, _data.string, text);
+        break;
+
+      case SETTING_TYPE_INFO:
+        visitor->visit(settingId, _data.info, text);
+        break;
+
+      default:
+        break;
+    }
+  }
+
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SETTING_VALUE_H__
+#define __SETTING_VALUE_H__
+
+#include <Arduino.h>
+
+#define SETTING_TYPE_UINT8	         0
+#define SETTING_TYPE_INT8	           1
+#define SETTING_TYPE_UINT16	         2
+#define SETTING_TYPE_INT16	         3
+#define SETTING_TYPE_FLOAT	         8
+#define SETTING_TYPE_TEXT_SELECTION  9
+#define SETTING_TYPE_STRING	        10
+#define SETTING_TYPE_FOLDER	        11
+#define SETTING_TYPE_INFO	          12
+
+#define SETTING_TYPE_NONE 0xff      // No detail has been read for the setting
+
+#define SETTING_VALUE_NO_TEXT 0xffff
+
+namespace RunCam {
+
+  struct UInt8Value {
+    uint8_t value;
+    uint8_t min;
+    uint8_t max;
+    uint8_t stepSize;
+  };
+
+  struct Int8Value {
+    int8_t value;
+    int8_t min;
+    int8_t max;
+    int8_t stepSize;
+  };
+
+  struct UInt16Value {
+    uint16_t value;
+    uint16_t min;
+    uint16_t max;
+    uint16_t stepSize;
+  };
+
+  struct Int16Value {
+    int16_t value;
+    int16_t min;
+    int16_t max;
+    int16_t stepSize;
+  };
+
+  // The camera sends the raw values, decimalPoint is the digit count after the decimal point
+  struct FloatValue {
+    int32_t value;
+    int32_t min;
+    int32_t max;
+    int16_t decimalPoint;
+    int32_t stepSize;
+  };
+
+  // The options are NUL separated text in the owning SettingsStore's pool
+  struct TextSelectionValue {
+    uint8_t value;
+    uint8_t optionCount;
+    uint16_t textOffset;
+  };
+
+  struct StringValue {
+    uint16_t textOffset;
+    uint8_t maxStringSize;
+  };
+
+  struct InfoValue {
+    uint16_t textOffset;
+  };
+
+  // Called with the variant held by a SettingValue.  Text is resolved against the owning store.
+  class SettingValueVisitor {
+    public:
+      virtual void visit(uint8_t /* settingId */, const UInt8Value & /* value */) {}
+      virtual void visit(uint8_t /* settingId */, const Int8Value & /* value */) {}
+      virtual void visit(uint8_t /* settingId */, const UInt16Value & /* value */) {}
+      virtual void visit(uint8_t /* settingId */, const Int16Value & /* value */) {}
+      virtual void visit(uint8_t /* settingId */, const FloatValue & /* value */) {}
+      // options holds value.optionCount NUL terminated strings back to back
+      virtual void visit(uint8_t /* settingId */, const TextSelectionValue & /* value */, const char * /* options */) {}
+      virtual void visit(uint8_t /* settingId */, const StringValue & /* value */, const char * /* text */) {}
+      virtual void visit(uint8_t /* settingId */, const InfoValue & /* value */, const char * /* text */) {}
+  };
+
+  // The detail of a setting as a tagged union of the SETTING_TYPE_* variants.  The as*() accessors
+  // return NULL unless the value holds that variant.
+  class SettingValue {
+    public:
+      SettingValue();
+
+      uint8_t getType() const;
+      bool isEmpty() const;
+      void clear();
+
+      void setUInt8(uint8_t value, uint8_t min, uint8_t max, uint8_t stepSize);
+      void setInt8(int8_t value, int8_t min, int8_t max, int8_t stepSize);
+      void setUInt16(uint16_t value, uint16_t min, uint16_t max, uint16_t stepSize);
+      void setInt16(int16_t value, int16_t min, int16_t max, int16_t stepSize);
+      void setFloat(int32_t value, int32_t min, int32_t max, int16_t decimalPoint, int32_t stepSize);
+      void setTextSelection(uint8_t value, uint8_t optionCount, uint16_t textOffset);
+      void setString(uint16_t textOffset, uint8_t maxStringSize);
+      void setInfo(uint16_t textOffset);
+
+      const UInt8Value *asUInt8() const;
+      const Int8Value *asInt8() const;
+      const UInt16Value *asUInt16() const;
+      const Int16Value *asInt16() const;
+      const FloatValue *asFloat() const;
+      const TextSelectionValue *asTextSelection() const;
+      const StringValue *asString() const;
+      const InfoValue *asInfo() const;
+
+      // The current value of the integer variants, or the selected index of a TEXT_SELECTION.  Returns
+      // false for the text variants.
+      bool getInteger(int32_t *value) const;
+
+      // Offset of the text in the owning store, SETTING_VALUE_NO_TEXT for the numeric variants
+      uint16_t getTextOffset() const;
+
+      // Points the text variants at text that has moved in the store, the numeric variants are unchanged
+      void setTextOffset(uint16_t textOffset);
+
+      void accept(uint8_t settingId, const char *pool, SettingValueVisitor *visitor) const;
+
+    private:
+      uint8_t _type;
+      union {
+        UInt8Value uint8;
+        Int8Value int8;
+        UInt16Value uint16;
+        Int16Value int16;
+        FloatValue float32;
+        TextSelectionValue textSelection;
+        StringValue string;
+        InfoValue info;
+      } _data;
+  };
+
+}
+
+#endif // __SETTING_VALUE_H__
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SETTINGS_CACHE_STORAGE_H__
+#define __SETTINGS_CACHE_STORAGE_H__
+
+#include <Arduino.h>
+
+namespace RunCam {
+
+  // Somewhere to keep a SettingsStore between boots, e.g. EEPROM or flash on a board or a file on Linux.
+  // Offsets start at 0 for the first byte of the cache.
+  class SettingsCacheStorage {
+    public:
+      virtual ~SettingsCacheStorage() {}
+
+      // Return the number of bytes transferred, less than length on failure
+      virtual size_t read(size_t offset, uint8_t *data, size_t length) = 0;
+      virtual size_t write(size_t offset, const uint8_t *data, size_t length) = 0;
+
+      // Called once a complete cache has been written
+      virtual bool commit() {
+        return true;
+      }
+  };
+
+}
+
+#endif // __SETTINGS_CACHE_STORAGE_H__
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SettingsProfile.h"
+
+namespace RunCam {
+
+  SettingsProfile::SettingsProfile(const char *name) {
+    setName(name);
+    _count = 0;
+  }
+
+  void SettingsProfile::setName(const char *name) {
+    strncpy(_name, name != NULL ? name : "", SETTINGS_PROFILE_MAX_NAME);
+    _name[SETTINGS_PROFILE_MAX_NAME] = '\0';
+  }
+
+  const char *SettingsProfile::getName() {
+    return _name;
+  }
+
+  void SettingsProfile::clear() {
+    _count = 0;
+  }
+
+  ProfileEntry *SettingsProfile::add(uint8_t settingId) {
+    ProfileEntry *entry = (ProfileEntry *)find(settingId);
+    if (entry != NULL) {
+      return entry;
+    }
+
+    if (_count == SETTINGS_PROFILE_MAX_ENTRIES) {
+      return NULL;
+    }
+
+    entry = &_entries[_count++];
+    entry->settingId = settingId;
+    return entry;
+  }
+
+  bool SettingsProfile::setValue(uint8_t settingId, uint8_t value) {
+    ProfileEntry *entry = add(settingId);
+    if (entry == NULL) {
+      return false;
+    }
+
+    entry->isText = false;
+    entry->value = value;
+    entry->text[0] = '\0';
+    return true;
+  }
+
+  bool SettingsProfile::setText(uint8_t settingId, const char *text) {
+    if (text == NULL || strlen(text) > SETTINGS_PROFILE_MAX_TEXT) {
+      return false;
+    }
+
+    ProfileEntry *entry = add(settingId);
+    if (entry == NULL) {
+      return false;
+    }
+
+    entry->isText = true;
+    entry->value = 0;
+    strcpy(entry->text, text);
+    return true;
+  }
+
+  uint8_t SettingsProfile::getCount() {
+    return _count;
+  }
+
+  const ProfileEntry *SettingsProfile::get(uint8_t index) {
+    if (index >= _count) {
+      return NULL;
+    }
+
+    return &_entries[index];
+  }
+
+  const ProfileEntry *SettingsProfile::find(uint8_t settingId) {
+    for (uint8_t i = 0; i < _count; i++) {
+      if (_entries[i].settingId == settingId) {
+        return &_entries[i];
+      }
+    }
+
+    return NULL;
+  }
+
+  uint8_t SettingsProfile::capture(SettingsStore *store, const uint8_t *settingIds, uint8_t count) {
+    uint8_t captured = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+      SettingRecord *record = store->find(settingIds[i]);
+      if (record == NULL) {
+        continue;
+      }
+
+      // Only the types that writeSetting() can set
+      bool added = false;
+      if (record->detail.asTextSelection() != NULL) {
+        added = setValue(record->id, record->detail.asTextSelection()->value);
+      } else if (record->detail.asUInt8() != NULL) {
+        added = setValue(record->id, record->detail.asUInt8()->value);
+      } else if (record->detail.asString() != NULL) {
+        added = setText(record->id, store->getText(record));
+      }
+
+      if (added) {
+        captured++;
+      }
+    }
+
+    return captured;
+  }
+
+  bool SettingsProfile::matches(const ProfileEntry *entry, SettingsStore *store, const SettingRecord *record) {
+    if (entry->isText) {
+      return record->detail.asString() != NULL && strcmp(store->getText(record), entry->text) == 0;
+    }
+
+    if (record->detail.asTextSelection() != NULL) {
+      return record->detail.asTextSelection()->value == entry->value;
+    }
+
+    if (record->detail.asUInt8() != NULL) {
+      return record->detail.asUInt8()->value == entry->value;
+    }
+
+    return false;
+  }
+
+}
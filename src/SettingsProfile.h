@@ -0,0 +1,77 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SETTINGS_PROFILE_H__
+#define __SETTINGS_PROFILE_H__
+
+#include <Arduino.h>
+#include "SettingsStore.h"
+
+#ifndef SETTINGS_PROFILE_MAX_ENTRIES
+#define SETTINGS_PROFILE_MAX_ENTRIES 8
+#endif
+
+#define SETTINGS_PROFILE_MAX_NAME 15
+#define SETTINGS_PROFILE_MAX_TEXT 32
+
+namespace RunCam {
+
+  // A setting as it is written: an option index or UINT8 value, or text for string settings
+  struct ProfileEntry {
+    uint8_t settingId;
+    bool isText;
+    uint8_t value;
+    char text[SETTINGS_PROFILE_MAX_TEXT + 1];
+  };
+
+  // A named set of setting values to put a camera into a known configuration.  Entries are written in the
+  // order they were added, which matters when one setting's options depend on another, e.g. resolution
+  // on TV mode.
+  class SettingsProfile {
+    public:
+      SettingsProfile(const char *name = "");
+
+      void setName(const char *name);
+      const char *getName();
+
+      void clear();
+
+      // Adds the setting or replaces its value.  false if the profile is full or the text too long.
+      bool setValue(uint8_t settingId, uint8_t value);
+      bool setText(uint8_t settingId, const char *text);
+
+      uint8_t getCount();
+      const ProfileEntry *get(uint8_t index);
+      const ProfileEntry *find(uint8_t settingId);
+
+      // Adds the current values of the given settings from a store.  Settings the store hasn't read a
+      // detail for, or that can't be written, are left out.  Returns how many were added.
+      uint8_t capture(SettingsStore *store, const uint8_t *settingIds, uint8_t count);
+
+      // Whether the stored setting already holds the entry's value
+      static bool matches(const ProfileEntry *entry, SettingsStore *store, const SettingRecord *record);
+
+    private:
+      char _name[SETTINGS_PROFILE_MAX_NAME + 1];
+      ProfileEntry _entries[SETTINGS_PROFILE_MAX_ENTRIES];
+      uint8_t _count;
+
+      ProfileEntry *add(uint8_t settingId);
+  };
+
+}
+
+#endif // __SETTINGS_PROFILE_H__
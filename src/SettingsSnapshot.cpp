@@ -0,0 +1,136 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SettingsSnapshot.h"
+
+#ifdef RUNCAM_HAS_ATOMIC
+
+namespace RunCam {
+
+  SettingsSnapshot::SettingsSnapshot() : _readers(0) {
+    _version = 0;
+    _publishTime = 0;
+  }
+
+  uint32_t SettingsSnapshot::getVersion() {
+    return _version;
+  }
+
+  unsigned long SettingsSnapshot::getPublishTime() {
+    return _publishTime;
+  }
+
+  SettingsStore *SettingsSnapshot::getSettings() {
+    return &_settings;
+  }
+
+  const SettingRecord *SettingsSnapshot::find(uint8_t settingId) {
+    return _settings.find(settingId);
+  }
+
+  const char *SettingsSnapshot::getValue(uint8_t settingId) {
+    const SettingRecord *record = _settings.find(settingId);
+    if (record == NULL) {
+      return "";
+    }
+
+    if (record->detail.asString() != NULL || record->detail.asInfo() != NULL) {
+      return _settings.getText(record);
+    }
+
+    return _settings.getValue(record);
+  }
+
+  const char *SettingsSnapshot::getSelectedOption(uint8_t settingId) {
+    const SettingRecord *record = _settings.find(settingId);
+    if (record == NULL || record->detail.asTextSelection() == NULL) {
+      return NULL;
+    }
+
+    return _settings.getOption(record, record->detail.asTextSelection()->value);
+  }
+
+  bool SettingsSnapshot::getInteger(uint8_t settingId, int32_t *value) {
+    const SettingRecord *record = _settings.find(settingId);
+    if (record == NULL) {
+      return false;
+    }
+
+    return record->detail.getInteger(value);
+  }
+
+  SettingsPublisher::SettingsPublisher() : _current(NULL) {
+    _version = 0;
+  }
+
+  uint32_t SettingsPublisher::getVersion() {
+    return _version;
+  }
+
+  // The reader count and the current pointer are sequentially consistent.  A reader counts itself in and
+  // then checks the snapshot is still current, while publish() swaps the pointer and then checks the
+  // counts, so at least one of them sees the other.
+  bool SettingsPublisher::publish(SettingsStore *settings) {
+    SettingsSnapshot *current = _current.load();
+
+    SettingsSnapshot *snapshot = NULL;
+    for (uint8_t i = 0; i < SETTINGS_SNAPSHOT_COUNT; i++) {
+      if (&_snapshots[i] != current && _snapshots[i]._readers.load() == 0) {
+        snapshot = &_snapshots[i];
+        break;
+      }
+    }
+
+    if (snapshot == NULL) {
+      return false;
+    }
+
+    // A reader that counts itself in from here on finds the copy isn't current and lets it go untouched
+    snapshot->_settings = *settings;
+    snapshot->_version = ++_version;
+    snapshot->_publishTime = millis();
+
+    _current.store(snapshot);
+    return true;
+  }
+
+  SettingsSnapshot *SettingsPublisher::acquire() {
+    for (;;) {
+      SettingsSnapshot *snapshot = _current.load();
+      if (snapshot == NULL) {
+        return NULL;
+      }
+
+      snapshot->_readers.fetch_add(1);
+
+      // Replaced before the count went up, so it may be about to be overwritten
+      if (_current.load() == snapshot) {
+        return snapshot;
+      }
+
+      snapshot->_readers.fetch_sub(1);
+    }
+  }
+
+  void SettingsPublisher::release(SettingsSnapshot *snapshot) {
+    if (snapshot != NULL) {
+      snapshot->_readers.fetch_sub(1);
+    }
+  }
+
+}
+
+#endif
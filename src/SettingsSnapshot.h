@@ -0,0 +1,99 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SETTINGS_SNAPSHOT_H__
+#define __SETTINGS_SNAPSHOT_H__
+
+#include <Arduino.h>
+#include "SettingsStore.h"
+#include "SpscRing.h"
+
+#ifdef RUNCAM_HAS_ATOMIC
+
+#include <atomic>
+
+// One is current, the rest can be held by readers of older versions while the next is published
+#ifndef SETTINGS_SNAPSHOT_COUNT
+#define SETTINGS_SNAPSHOT_COUNT 3
+#endif
+
+namespace RunCam {
+
+  // An immutable copy of the settings as they were when it was published.  Everything it returns stays
+  // valid until the snapshot is released.
+  class SettingsSnapshot {
+    public:
+      SettingsSnapshot();
+
+      // Counts up from 1 with each publish
+      uint32_t getVersion();
+      unsigned long getPublishTime();
+
+      // Read only.  The store's methods are safe to call since nothing writes to it while it is held.
+      SettingsStore *getSettings();
+
+      // NULL if the setting has not been read
+      const SettingRecord *find(uint8_t settingId);
+
+      // The value as text, from the detail for string and info settings and the settings list otherwise.
+      // "" if the setting has not been read.
+      const char *getValue(uint8_t settingId);
+
+      // The selected option of a text selection, NULL if there is none
+      const char *getSelectedOption(uint8_t settingId);
+
+      bool getInteger(uint8_t settingId, int32_t *value);
+
+    private:
+      friend class SettingsPublisher;
+
+      SettingsStore _settings;
+      uint32_t _version;
+      unsigned long _publishTime;
+      std::atomic<uint8_t> _readers;
+  };
+
+  // Read-copy-update for settings.  The one thread that refreshes the settings publishes a copy of them
+  // after each change by swapping a single pointer.  Any thread can acquire the current copy without
+  // locking and reads a consistent set of settings, however many publishes happen meanwhile.  A copy is
+  // only reused once it is no longer current and every reader has released it.
+  //
+  // Copies come from a fixed pool.  publish() fails, leaving the previous copy current, if readers are
+  // holding every other one.
+  class SettingsPublisher {
+    public:
+      SettingsPublisher();
+
+      // Writer
+      bool publish(SettingsStore *settings);
+      uint32_t getVersion();
+
+      // Readers, from any thread.  acquire() returns NULL until the first publish.  Hold a snapshot only
+      // as long as needed, each one held keeps a copy from being reused.
+      SettingsSnapshot *acquire();
+      void release(SettingsSnapshot *snapshot);
+
+    private:
+      SettingsSnapshot _snapshots[SETTINGS_SNAPSHOT_COUNT];
+      std::atomic<SettingsSnapshot *> _current;
+      uint32_t _version;
+  };
+
+}
+
+#endif
+
+#endif // __SETTINGS_SNAPSHOT_H__
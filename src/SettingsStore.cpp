@@ -0,0 +1,498 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SettingsStore.h"
+#include "Crc8.h"
+
+namespace RunCam {
+
+  SettingsStore::SettingsStore() {
+    _peakMemoryUsage = 0;
+    clear();
+  }
+
+  void SettingsStore::clear() {
+    _count = 0;
+    _poolUsed = 0;
+    buildIndex();
+  }
+
+  // Records are never removed or moved, so the index only needs rebuilding when they are replaced wholesale
+  void SettingsStore::buildIndex() {
+    memset(_index, SETTINGS_STORE_NO_SLOT, sizeof(_index));
+
+    for (uint8_t i = 0; i < _count; i++) {
+      if (_records[i].id < SETTINGS_STORE_INDEX_SIZE) {
+        _index[_records[i].id] = i;
+      }
+    }
+  }
+
+  SettingRecord *SettingsStore::add(uint8_t id) {
+    SettingRecord *record = find(id);
+    if (record != NULL) {
+      return record;
+    }
+
+    if (_count == SETTINGS_STORE_MAX_SETTINGS) {
+      return NULL;
+    }
+
+    if (id < SETTINGS_STORE_INDEX_SIZE) {
+      _index[id] = _count;
+    }
+
+    record = &_records[_count++];
+    record->id = id;
+    record->nameOffset = SETTINGS_STORE_NO_STRING;
+    record->valueOffset = SETTINGS_STORE_NO_STRING;
+    record->detail.clear();
+    record->updateTime = 0;
+    record->stale = true;
+
+    updatePeak();
+
+    return record;
+  }
+
+  SettingRecord *SettingsStore::find(uint8_t id) {
+    if (id < SETTINGS_STORE_INDEX_SIZE) {
+      uint8_t slot = _index[id];
+      return slot == SETTINGS_STORE_NO_SLOT ? NULL : &_records[slot];
+    }
+
+    for (uint8_t i = 0; i < _count; i++) {
+      if (_records[i].id == id) {
+        return &_records[i];
+      }
+    }
+
+    return NULL;
+  }
+
+  uint8_t SettingsStore::getCount() {
+    return _count;
+  }
+
+  SettingRecord *SettingsStore::get(uint8_t index) {
+    if (index >= _count) {
+      return NULL;
+    }
+
+    return &_records[index];
+  }
+
+  void SettingsStore::invalidate(uint8_t id) {
+    SettingRecord *record = find(id);
+    if (record != NULL) {
+      record->stale = true;
+    }
+  }
+
+  void SettingsStore::invalidateAll() {
+    for (uint8_t i = 0; i < _count; i++) {
+      _records[i].stale = true;
+    }
+  }
+
+  // Each string is preceded by a byte holding the most characters its slot can take
+  uint16_t SettingsStore::addString(const uint8_t *string, size_t length) {
+    if (length > 0xff || _poolUsed + length + 2 > SETTINGS_STORE_POOL_SIZE) {
+      return SETTINGS_STORE_NO_STRING;
+    }
+
+    uint16_t offset = _poolUsed + 1;
+    _pool[offset - 1] = length;
+    memcpy(&_pool[offset], string, length);
+    _pool[offset + length] = 0;
+    _poolUsed += length + 2;
+
+    updatePeak();
+
+    return offset;
+  }
+
+  uint16_t SettingsStore::setString(uint16_t offset, const uint8_t *string, size_t length) {
+    if (offset == SETTINGS_STORE_NO_STRING || length > (uint8_t)_pool[offset - 1]) {
+      uint16_t added = addString(string, length);
+      if (added == SETTINGS_STORE_NO_STRING) {
+        compact(offset);
+        added = addString(string, length);
+      }
+
+      return added;
+    }
+
+    memcpy(&_pool[offset], string, length);
+    _pool[offset + length] = 0;
+
+    return offset;
+  }
+
+  void SettingsStore::compact() {
+    compact(SETTINGS_STORE_NO_STRING);
+  }
+
+  // Slides the strings a record still points at down over the ones outgrown by a longer value, fixing up
+  // the records as they move.  replaced is a slot its owner is giving up, so it goes too.
+  void SettingsStore::compact(uint16_t replaced) {
+    uint16_t used = 0;
+    uint16_t slot = 0;
+
+    while (slot < _poolUsed) {
+      uint16_t offset = slot + 1;
+      uint16_t size = (uint8_t)_pool[slot] + 2;
+      uint16_t moved = used + 1;
+      bool live = false;
+
+      slot += size;
+      if (offset == replaced) {
+        continue;
+      }
+
+      // Moved strings only go down, so they never clash with the offsets still to be checked
+      for (uint8_t i = 0; i < _count; i++) {
+        SettingRecord *record = &_records[i];
+
+        if (record->nameOffset == offset) {
+          record->nameOffset = moved;
+          live = true;
+        }
+        if (record->valueOffset == offset) {
+          record->valueOffset = moved;
+          live = true;
+        }
+        if (record->detail.getTextOffset() == offset) {
+          record->detail.setTextOffset(moved);
+          live = true;
+        }
+      }
+
+      if (live) {
+        memmove(&_pool[used], &_pool[offset - 1], size);
+        used += size;
+      }
+    }
+
+    _poolUsed = used;
+  }
+
+  const char *SettingsStore::getString(uint16_t offset) {
+    if (offset == SETTINGS_STORE_NO_STRING) {
+      return "";
+    }
+
+    return &_pool[offset];
+  }
+
+  const char *SettingsStore::getName(const SettingRecord *record) {
+    return getString(record->nameOffset);
+  }
+
+  const char *SettingsStore::getValue(const SettingRecord *record) {
+    return getString(record->valueOffset);
+  }
+
+  const char *SettingsStore::getText(const SettingRecord *record) {
+    return getString(record->detail.getTextOffset());
+  }
+
+  // Options are stored back to back, each with its own terminator.  Returns NULL for an invalid index.
+  const char *SettingsStore::getOption(const SettingRecord *record, uint8_t index) {
+    const TextSelectionValue *selection = record->detail.asTextSelection();
+    if (selection == NULL || index >= selection->optionCount || selection->textOffset == SETTINGS_STORE_NO_STRING) {
+      return NULL;
+    }
+
+    const char *option = &_pool[selection->textOffset];
+    for (uint8_t i = 0; i < index; i++) {
+      option += strlen(option) + 1;
+    }
+
+    return option;
+  }
+
+  void SettingsStore::visit(const SettingRecord *record, SettingValueVisitor *visitor) {
+    record->detail.accept(record->id, _pool, visitor);
+  }
+
+  static uint8_t crcUpdate(uint8_t crc, const uint8_t *buf, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+      crc = Crc8::update(crc, buf[i]);
+    }
+
+    return crc;
+  }
+
+  // Little endian, whatever the board
+  static void putUInt16(uint8_t *buf, uint16_t value) {
+    buf[0] = value;
+    buf[1] = value >> 8;
+  }
+
+  static void putUInt32(uint8_t *buf, uint32_t value) {
+    putUInt16(buf, value);
+    putUInt16(buf + 2, value >> 16);
+  }
+
+  static uint16_t getUInt16(const uint8_t *buf) {
+    return buf[0] | (buf[1] << 8);
+  }
+
+  static uint32_t getUInt32(const uint8_t *buf) {
+    return getUInt16(buf) | ((uint32_t)getUInt16(buf + 2) << 16);
+  }
+
+  // Written ahead of the records and pool
+  struct SettingsCacheHeader {
+    uint16_t magic;
+    uint8_t format;
+    uint8_t recordSize;
+    uint32_t key;
+    uint8_t count;
+    uint8_t crc;            // Of the records and pool
+    uint16_t poolUsed;
+  };
+
+  // [magic] [format] [record size] [key] [count] [crc] [pool used]
+  static void encodeHeader(const SettingsCacheHeader *header, uint8_t *buf) {
+    putUInt16(buf, header->magic);
+    buf[2] = header->format;
+    buf[3] = header->recordSize;
+    putUInt32(buf + 4, header->key);
+    buf[8] = header->count;
+    buf[9] = header->crc;
+    putUInt16(buf + 10, header->poolUsed);
+  }
+
+  static void decodeHeader(const uint8_t *buf, SettingsCacheHeader *header) {
+    header->magic = getUInt16(buf);
+    header->format = buf[2];
+    header->recordSize = buf[3];
+    header->key = getUInt32(buf + 4);
+    header->count = buf[8];
+    header->crc = buf[9];
+    header->poolUsed = getUInt16(buf + 10);
+  }
+
+  // [id] [name offset] [value offset] [detail type] [detail fields...], zero filled to the record size
+  static void encodeRecord(const SettingRecord *record, uint8_t *buf) {
+    const SettingValue *detail = &record->detail;
+    uint8_t *fields = buf + 6;
+
+    memset(buf, 0, SETTINGS_CACHE_RECORD_SIZE);
+    buf[0] = record->id;
+    putUInt16(buf + 1, record->nameOffset);
+    putUInt16(buf + 3, record->valueOffset);
+    buf[5] = detail->getType();
+
+    if (detail->asUInt8() != NULL) {
+      const UInt8Value *value = detail->asUInt8();
+      fields[0] = value->value;
+      fields[1] = value->min;
+      fields[2] = value->max;
+      fields[3] = value->stepSize;
+    } else if (detail->asInt8() != NULL) {
+      const Int8Value *value = detail->asInt8();
+      fields[0] = value->value;
+      fields[1] = value->min;
+      fields[2] = value->max;
+      fields[3] = value->stepSize;
+    } else if (detail->asUInt16() != NULL) {
+      const UInt16Value *value = detail->asUInt16();
+      putUInt16(fields, value->value);
+      putUInt16(fields + 2, value->min);
+      putUInt16(fields + 4, value->max);
+      putUInt16(fields + 6, value->stepSize);
+    } else if (detail->asInt16() != NULL) {
+      const Int16Value *value = detail->asInt16();
+      putUInt16(fields, value->value);
+      putUInt16(fields + 2, value->min);
+      putUInt16(fields + 4, value->max);
+      putUInt16(fields + 6, value->stepSize);
+    } else if (detail->asFloat() != NULL) {
+      const FloatValue *value = detail->asFloat();
+      putUInt32(fields, value->value);
+      putUInt32(fields + 4, value->min);
+      putUInt32(fields + 8, value->max);
+      putUInt16(fields + 12, value->decimalPoint);
+      putUInt32(fields + 14, value->stepSize);
+    } else if (detail->asTextSelection() != NULL) {
+      const TextSelectionValue *value = detail->asTextSelection();
+      fields[0] = value->value;
+      fields[1] = value->optionCount;
+      putUInt16(fields + 2, value->textOffset);
+    } else if (detail->asString() != NULL) {
+      const StringValue *value = detail->asString();
+      putUInt16(fields, value->textOffset);
+      fields[2] = value->maxStringSize;
+    } else if (detail->asInfo() != NULL) {
+      putUInt16(fields, detail->asInfo()->textOffset);
+    }
+  }
+
+  // Returns false for a detail type this build doesn't know
+  static bool decodeRecord(const uint8_t *buf, SettingRecord *record) {
+    SettingValue *detail = &record->detail;
+    const uint8_t *fields = buf + 6;
+
+    record->id = buf[0];
+    record->nameOffset = getUInt16(buf + 1);
+    record->valueOffset = getUInt16(buf + 3);
+    record->updateTime = 0;
+    record->stale = true;
+
+    switch (buf[5]) {
+      case SETTING_TYPE_NONE:
+        detail->clear();
+        return true;
+
+      case SETTING_TYPE_UINT8:
+        detail->setUInt8(fields[0], fields[1], fields[2], fields[3]);
+        return true;
+
+      case SETTING_TYPE_INT8:
+        detail->setInt8(fields[0], fields[1], fields[2], fields[3]);
+        return true;
+
+      case SETTING_TYPE_UINT16:
+        detail->setUInt16(getUInt16(fields), getUInt16(fields + 2), getUInt16(fields + 4), getUInt16(fields + 6));
+        return true;
+
+      case SETTING_TYPE_INT16:
+        detail->setInt16(getUInt16(fields), getUInt16(fields + 2), getUInt16(fields + 4), getUInt16(fields + 6));
+        return true;
+
+      case SETTING_TYPE_FLOAT:
+        detail->setFloat(getUInt32(fields), getUInt32(fields + 4), getUInt32(fields + 8), getUInt16(fields + 12), getUInt32(fields + 14));
+        return true;
+
+      case SETTING_TYPE_TEXT_SELECTION:
+        detail->setTextSelection(fields[0], fields[1], getUInt16(fields + 2));
+        return true;
+
+      case SETTING_TYPE_STRING:
+        detail->setString(getUInt16(fields), fields[2]);
+        return true;
+
+      case SETTING_TYPE_INFO:
+        detail->setInfo(getUInt16(fields));
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+  bool SettingsStore::save(SettingsCacheStorage *storage, uint32_t key) {
+    SettingsCacheHeader header;
+    header.magic = SETTINGS_CACHE_MAGIC;
+    header.format = SETTINGS_CACHE_FORMAT;
+    header.recordSize = SETTINGS_CACHE_RECORD_SIZE;
+    header.key = key;
+    header.count = _count;
+    header.poolUsed = _poolUsed;
+
+    uint8_t buf[SETTINGS_CACHE_RECORD_SIZE];
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+      encodeRecord(&_records[i], buf);
+      crc = crcUpdate(crc, buf, sizeof(buf));
+    }
+    header.crc = crcUpdate(crc, (const uint8_t*)_pool, _poolUsed);
+
+    uint8_t headerBuf[SETTINGS_CACHE_HEADER_SIZE];
+    encodeHeader(&header, headerBuf);
+
+    size_t offset = 0;
+    if (storage->write(offset, headerBuf, sizeof(headerBuf)) != sizeof(headerBuf)) {
+      return false;
+    }
+    offset += sizeof(headerBuf);
+
+    for (uint8_t i = 0; i < _count; i++) {
+      encodeRecord(&_records[i], buf);
+      if (storage->write(offset, buf, sizeof(buf)) != sizeof(buf)) {
+        return false;
+      }
+      offset += sizeof(buf);
+    }
+
+    if (storage->write(offset, (const uint8_t*)_pool, _poolUsed) != _poolUsed) {
+      return false;
+    }
+
+    return storage->commit();
+  }
+
+  bool SettingsStore::load(SettingsCacheStorage *storage, uint32_t key) {
+    clear();
+
+    uint8_t headerBuf[SETTINGS_CACHE_HEADER_SIZE];
+    if (storage->read(0, headerBuf, sizeof(headerBuf)) != sizeof(headerBuf)) {
+      return false;
+    }
+
+    SettingsCacheHeader header;
+    decodeHeader(headerBuf, &header);
+
+    if (header.magic != SETTINGS_CACHE_MAGIC || header.format != SETTINGS_CACHE_FORMAT || header.recordSize != SETTINGS_CACHE_RECORD_SIZE ||
+        header.key != key || header.count > SETTINGS_STORE_MAX_SETTINGS || header.poolUsed > SETTINGS_STORE_POOL_SIZE) {
+      return false;
+    }
+
+    // Decode straight into the store, it is cleared again if anything doesn't check out
+    uint8_t buf[SETTINGS_CACHE_RECORD_SIZE];
+    uint8_t crc = 0;
+    size_t offset = sizeof(headerBuf);
+    for (uint8_t i = 0; i < header.count; i++) {
+      if (storage->read(offset, buf, sizeof(buf)) != sizeof(buf) || !decodeRecord(buf, &_records[i])) {
+        return false;
+      }
+      crc = crcUpdate(crc, buf, sizeof(buf));
+      offset += sizeof(buf);
+    }
+
+    if (storage->read(offset, (uint8_t*)_pool, header.poolUsed) != header.poolUsed ||
+        crcUpdate(crc, (const uint8_t*)_pool, header.poolUsed) != header.crc) {
+      return false;
+    }
+
+    _count = header.count;
+    _poolUsed = header.poolUsed;
+    buildIndex();
+    updatePeak();
+
+    return true;
+  }
+
+  size_t SettingsStore::getMemoryUsage() {
+    return _count * sizeof(SettingRecord) + _poolUsed;
+  }
+
+  size_t SettingsStore::getPeakMemoryUsage() {
+    return _peakMemoryUsage;
+  }
+
+  void SettingsStore::updatePeak() {
+    size_t usage = getMemoryUsage();
+
+    if (usage > _peakMemoryUsage) {
+      _peakMemoryUsage = usage;
+    }
+  }
+
+}
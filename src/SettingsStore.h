@@ -0,0 +1,128 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SETTINGS_STORE_H__
+#define __SETTINGS_STORE_H__
+
+#include <Arduino.h>
+#include "SettingValue.h"
+#include "SettingsCacheStorage.h"
+
+#ifndef SETTINGS_STORE_MAX_SETTINGS
+#define SETTINGS_STORE_MAX_SETTINGS 16
+#endif
+
+#ifndef SETTINGS_STORE_POOL_SIZE
+#define SETTINGS_STORE_POOL_SIZE 512
+#endif
+
+// Settings with ids below this are found with a direct lookup, the rest by searching the records
+#ifndef SETTINGS_STORE_INDEX_SIZE
+#define SETTINGS_STORE_INDEX_SIZE 32
+#endif
+
+#define SETTINGS_STORE_NO_SLOT 0xff
+
+#if SETTINGS_STORE_MAX_SETTINGS >= SETTINGS_STORE_NO_SLOT
+#error SETTINGS_STORE_MAX_SETTINGS must be less than 255
+#endif
+
+#define SETTINGS_STORE_NO_STRING SETTING_VALUE_NO_TEXT
+
+#define SETTINGS_CACHE_MAGIC 0x5243         // "RC"
+#define SETTINGS_CACHE_FORMAT 2             // Bump when the cache layout changes
+#define SETTINGS_CACHE_HEADER_SIZE 12       // Magic, format, record size, key, count, CRC and pool size
+#define SETTINGS_CACHE_RECORD_SIZE 24       // Id, name and value offsets, detail type and the largest detail
+
+namespace RunCam {
+
+  // A setting and its detail packed into a fixed size record.  Strings are offsets into the store's pool.
+  struct SettingRecord {
+    uint8_t id;
+    uint16_t nameOffset;        // From the setting list
+    uint16_t valueOffset;       // From the setting list
+    SettingValue detail;        // Empty until the detail has been read
+    unsigned long updateTime;   // millis() when the setting or its detail was last read
+    bool stale;                 // Set by invalidate() until the setting is read again
+  };
+
+  // Holds settings and their details in a fixed arena so reading them never touches the heap
+  class SettingsStore {
+    public:
+      SettingsStore();
+
+      void clear();
+
+      // Returns the record for the setting, adding one if needed.  NULL if the store is full.
+      SettingRecord *add(uint8_t id);
+      SettingRecord *find(uint8_t id);
+
+      uint8_t getCount();
+      SettingRecord *get(uint8_t index);
+
+      // Marks settings as needing to be read again, for example after a write changed them
+      void invalidate(uint8_t id);
+      void invalidateAll();
+
+      // Copies a string into the pool.  Returns its offset, or SETTINGS_STORE_NO_STRING if the pool is full.
+      uint16_t addString(const uint8_t *string, size_t length);
+
+      // Overwrites the string at offset when the new one fits in its slot, otherwise adds it.  Refreshing a
+      // setting with the same or a shorter value therefore uses no more of the pool.  If the pool is full it
+      // is compacted, dropping the string at offset too, before giving up.
+      uint16_t setString(uint16_t offset, const uint8_t *string, size_t length);
+      const char *getString(uint16_t offset);
+
+      // Squeezes out the strings no record uses any more, left behind when a value outgrew its slot.  This
+      // moves strings, so pointers from getString() and friends are only good until the next compact() or
+      // setString().
+      void compact();
+
+      const char *getName(const SettingRecord *record);
+      const char *getValue(const SettingRecord *record);
+      const char *getText(const SettingRecord *record);
+      const char *getOption(const SettingRecord *record, uint8_t index);
+
+      void visit(const SettingRecord *record, SettingValueVisitor *visitor);
+
+      // Copy the store to and from storage.  key identifies what the cache is valid for, e.g. the camera
+      // firmware version and feature mask.  load() fails, leaving the store empty, unless the cache was
+      // saved with the same key by a build with the same cache format.  Records are written field by field,
+      // without padding or read times, so saving settings that haven't changed writes the same bytes.
+      // Loaded records are marked stale with an updateTime of 0 so the caller decides which to trust.
+      bool save(SettingsCacheStorage *storage, uint32_t key);
+      bool load(SettingsCacheStorage *storage, uint32_t key);
+
+      // Bytes of records and pool in use now, and the most ever in use
+      size_t getMemoryUsage();
+      size_t getPeakMemoryUsage();
+
+    private:
+      SettingRecord _records[SETTINGS_STORE_MAX_SETTINGS];
+      uint8_t _count;
+      uint8_t _index[SETTINGS_STORE_INDEX_SIZE];     // Slot in _records by setting id
+      char _pool[SETTINGS_STORE_POOL_SIZE];
+      uint16_t _poolUsed;
+      size_t _peakMemoryUsage;
+
+      void updatePeak();
+      void buildIndex();
+      void compact(uint16_t replaced);
+  };
+
+}
+
+#endif // __SETTINGS_STORE_H__
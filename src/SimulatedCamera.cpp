@@ -0,0 +1,621 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <Arduino.h>
+#include "SimulatedCamera.h"
+#include "Crc8.h"
+
+namespace RunCam {
+
+  static const SimulatedSetting DEFAULT_SETTINGS[SIMULATED_CAMERA_SETTING_COUNT] = {
+    { SETTINGID_DISP_CHARSET, SETTING_TYPE_TEXT_SELECTION, "CHARSET", "BF;INAV;ArduPilot", 0, 0, 2, 0, true, false, "" },
+    { SETTINGID_DISP_COLUMNS, SETTING_TYPE_UINT8, "COLUMNS", NULL, SIMULATED_CAMERA_COLUMNS, SIMULATED_CAMERA_COLUMNS, SIMULATED_CAMERA_COLUMNS, 0, false, false, "" },
+    { SETTINGID_DISP_TV_MODE, SETTING_TYPE_TEXT_SELECTION, "TV_MODE", "NTSC;PAL", 1, 0, 1, 0, true, true, "" },
+    { SETTINGID_DISP_SDCARD_CAPACITY, SETTING_TYPE_STRING, "SDCARD_CAPACITY", NULL, 0, 0, 0, 20, false, false, "7.5G/29.8G" },
+    { SETTINGID_DISP_REMAIN_RECORDING_TIME, SETTING_TYPE_STRING, "REMAIN_RECORDING_TIME", NULL, 0, 0, 0, 20, false, false, "01:02:03" },
+    { SETTINGID_DISP_RESOLUTION, SETTING_TYPE_TEXT_SELECTION, "RESOLUTION", "1080@60;1080@50;1080@30;720@60", 0, 0, 3, 0, true, true, "" },
+    { SETTINGID_DISP_CAMERA_TIME, SETTING_TYPE_STRING, "CAMERA_TIME", NULL, 0, 0, 0, 20, true, false, "2024-01-01 00:00:00" }
+  };
+
+  // Remaining recording time for each resolution, so a resolution write really does change another setting
+  static const char *REMAINING_RECORDING_TIMES[] = { "01:02:03", "01:14:27", "02:04:06", "02:19:40" };
+
+  SimulatedCamera::SimulatedCamera(unsigned long baudRate, unsigned long bootTime) {
+    _baudRate = baudRate;
+    _uartBaudRate = 0;
+    _byteTime = (10000000UL + baudRate - 1) / baudRate;
+    _bootTime = bootTime;
+    _turnaroundTime = SIMULATED_CAMERA_DEFAULT_TURNAROUND_US;
+    _powerOnTime = 0;
+
+    reset();
+  }
+
+  void SimulatedCamera::reset() {
+    _txFreeTime = 0;
+    _rxFreeTime = 0;
+    _requestLength = 0;
+    _noiseLength = 0;
+    _rxHead = 0;
+    _rxCount = 0;
+
+    memcpy(_settings, DEFAULT_SETTINGS, sizeof(_settings));
+    memset(_screen, ' ', sizeof(_screen));
+    _recording = false;
+    _fiveKeyConnected = false;
+
+    _requestCount = 0;
+    _displayCommandCount = 0;
+    _droppedByteCount = 0;
+    _bytesReceived = 0;
+    _bytesSent = 0;
+  }
+
+  void SimulatedCamera::powerOn() {
+    reset();
+    _powerOnTime = micros();
+    _txFreeTime = _powerOnTime;
+    _rxFreeTime = _powerOnTime;
+  }
+
+  bool SimulatedCamera::isBooted() {
+    return micros() - _powerOnTime >= _bootTime * 1000UL;
+  }
+
+  void SimulatedCamera::setTurnaroundTime(unsigned long turnaroundTime) {
+    _turnaroundTime = turnaroundTime;
+  }
+
+  bool SimulatedCamera::injectNoise(const uint8_t *data, uint8_t length) {
+    if (_noiseLength + length > BUFF_SIZE) {
+      return false;
+    }
+
+    memcpy(_noise + _noiseLength, data, length);
+    _noiseLength += length;
+    return true;
+  }
+
+  // Microseconds to send one byte at the current baud rate
+  unsigned long SimulatedCamera::getByteTime() {
+    return _byteTime;
+  }
+
+  bool SimulatedCamera::isRecording() {
+    return _recording;
+  }
+
+  bool SimulatedCamera::isFiveKeyConnected() {
+    return _fiveKeyConnected;
+  }
+
+  uint8_t SimulatedCamera::getScreenChar(uint8_t x, uint8_t y) {
+    if (x >= SIMULATED_CAMERA_COLUMNS || y >= SIMULATED_CAMERA_ROWS) {
+      return 0;
+    }
+
+    return _screen[y][x];
+  }
+
+  SimulatedSetting *SimulatedCamera::getSetting(uint8_t settingId) {
+    for (uint8_t i = 0; i < SIMULATED_CAMERA_SETTING_COUNT; i++) {
+      if (_settings[i].id == settingId) {
+        return &_settings[i];
+      }
+    }
+
+    return NULL;
+  }
+
+  uint32_t SimulatedCamera::getRequestCount() {
+    return _requestCount;
+  }
+
+  uint32_t SimulatedCamera::getDisplayCommandCount() {
+    return _displayCommandCount;
+  }
+
+  uint32_t SimulatedCamera::getDroppedByteCount() {
+    return _droppedByteCount;
+  }
+
+  uint32_t SimulatedCamera::getBytesReceived() {
+    return _bytesReceived;
+  }
+
+  uint32_t SimulatedCamera::getBytesSent() {
+    return _bytesSent;
+  }
+
+  void SimulatedCamera::begin(unsigned long baudRate) {
+    _uartBaudRate = baudRate;
+    _byteTime = (10000000UL + baudRate - 1) / baudRate;
+  }
+
+  void SimulatedCamera::begin(unsigned long baudRate, uint16_t /* config */) {
+    begin(baudRate);
+  }
+
+  void SimulatedCamera::end() {
+    _uartBaudRate = 0;
+    _requestLength = 0;
+    _rxCount = 0;
+  }
+
+  SimulatedCamera::operator bool() {
+    return true;
+  }
+
+  // Response bytes are queued with the time they finish arriving, and only counted once that has passed
+  int SimulatedCamera::available() {
+    unsigned long now = micros();
+    int count = 0;
+
+    while (count < _rxCount && (long)(now - _rxTime[(_rxHead + count) % SIMULATED_CAMERA_RX_SIZE]) >= 0) {
+      count++;
+    }
+
+    return count;
+  }
+
+  int SimulatedCamera::peek() {
+    if (available() == 0) {
+      return -1;
+    }
+
+    return _rx[_rxHead];
+  }
+
+  int SimulatedCamera::read() {
+    if (available() == 0) {
+      return -1;
+    }
+
+    uint8_t data = _rx[_rxHead];
+    _rxHead = (_rxHead + 1) % SIMULATED_CAMERA_RX_SIZE;
+    _rxCount--;
+
+    return data;
+  }
+
+  // Wait until everything written has been clocked out
+  void SimulatedCamera::flush() {
+    while ((long)(_txFreeTime - micros()) > 0) {
+      yield();
+    }
+  }
+
+  size_t SimulatedCamera::write(uint8_t data) {
+    if (_uartBaudRate == 0) {
+      return 0;
+    }
+
+    unsigned long now = micros();
+    if ((long)(_txFreeTime - now) < 0) {
+      _txFreeTime = now;
+    }
+
+    _txFreeTime += _byteTime;
+    _bytesReceived++;
+
+    receive(data, _txFreeTime);
+
+    // Like a real UART, block while the transmit FIFO is full
+    while ((long)(_txFreeTime - micros()) > (long)(SIMULATED_CAMERA_TX_FIFO_SIZE * _byteTime)) {
+      yield();
+    }
+
+    return 1;
+  }
+
+  void SimulatedCamera::receive(uint8_t data, unsigned long arrivalTime) {
+    // Garbled by a baud rate mismatch, or the camera isn't listening yet
+    if (_uartBaudRate != _baudRate || arrivalTime - _powerOnTime < _bootTime * 1000UL) {
+      _droppedByteCount++;
+      _requestLength = 0;
+      return;
+    }
+
+    if (_requestLength == 0 && data != COMMAND_HEADER) {
+      _droppedByteCount++;
+      return;
+    }
+
+    _request[_requestLength++] = data;
+
+    int length = getRequestLength();
+    if (length < 0 || length > BUFF_SIZE) {
+      _droppedByteCount += _requestLength;
+      _requestLength = 0;
+      return;
+    }
+
+    if (length == 0 || _requestLength < length) {
+      return;
+    }
+
+    if (Crc8::calc(_request, length - 1) == _request[length - 1]) {
+      handleRequest(arrivalTime);
+    } else {
+      _droppedByteCount += length;
+    }
+
+    _requestLength = 0;
+  }
+
+  // The full length of the request being received, 0 if not enough of it has arrived to tell, or -1 if the
+  // command is unknown
+  int SimulatedCamera::getRequestLength() {
+    if (_requestLength < 2) {
+      return 0;
+    }
+
+    switch (_request[1]) {
+      case COMMAND_READ_CAMERA_INFO:
+      case COMMAND_FIVE_KEY_SIMULATION_RELEASE:
+        return 3;
+
+      case COMMAND_CAMERA_CONTROL:
+      case COMMAND_FIVE_KEY_SIMULATION_PRESS:
+      case COMMAND_FIVE_KEY_SIMULATION_CONNECTION:
+        return 4;
+
+      case COMMAND_GET_SETTINGS:
+      case COMMAND_READ_SETTING_DETAIL:
+        return 5;
+
+      case COMMAND_WRITE_SETTING: {
+        // Strings carry their length, everything else a single value byte
+        if (_requestLength < 4) {
+          return 0;
+        }
+
+        SimulatedSetting *setting = getSetting(_request[2]);
+        if (setting != NULL && setting->type == SETTING_TYPE_STRING) {
+          return _request[3] + 5;
+        }
+
+        return 5;
+      }
+
+      case COMMAND_DISPLAY_FILL_REGION:
+        return 8;
+
+      case COMMAND_DISPLAY_WRITE_CHAR:
+        return 6;
+
+      case COMMAND_DISPLAY_WRITE_HORIZONTAL_STRING:
+      case COMMAND_DISPLAY_WRITE_VERTICAL_STRING:
+        return _requestLength < 3 ? 0 : _request[2] + 6;
+
+      case COMMAND_DISPLAY_WRITE_STRING:
+        return _requestLength < 3 ? 0 : _request[2] + 4;
+
+      default:
+        return -1;
+    }
+  }
+
+  void SimulatedCamera::handleRequest(unsigned long arrivalTime) {
+    uint8_t frame[BUFF_SIZE];
+
+    _requestCount++;
+
+    switch (_request[1]) {
+      case COMMAND_READ_CAMERA_INFO: {
+        frame[1] = SIMULATED_CAMERA_VERSION;
+        frame[2] = SIMULATED_CAMERA_FEATURES & 0xff;
+        frame[3] = SIMULATED_CAMERA_FEATURES >> 8;
+        respond(frame, 5, arrivalTime);
+        break;
+      }
+
+      case COMMAND_CAMERA_CONTROL: {
+        // No response
+        if (_request[2] == RCDEVICE_PROTOCOL_CHANGE_START_RECORDING) {
+          _recording = true;
+        } else if (_request[2] == RCDEVICE_PROTOCOL_CHANGE_STOP_RECORDING) {
+          _recording = false;
+        } else if (_request[2] == RCDEVICE_PROTOCOL_SIMULATE_POWER_BTN) {
+          _recording = !_recording;
+        }
+        break;
+      }
+
+      case COMMAND_FIVE_KEY_SIMULATION_PRESS:
+      case COMMAND_FIVE_KEY_SIMULATION_RELEASE: {
+        respond(frame, 2, arrivalTime);
+        break;
+      }
+
+      case COMMAND_FIVE_KEY_SIMULATION_CONNECTION: {
+        uint8_t actionId = _request[2];
+        _fiveKeyConnected = actionId == RCDEVICE_PROTOCOL_5KEY_FUNCTION_OPEN;
+
+        // [ (Action ID << 4) + Response result(1：Succes 0：Failure) ]
+        frame[1] = (actionId << 4) | 1;
+        respond(frame, 3, arrivalTime);
+        break;
+      }
+
+      case COMMAND_GET_SETTINGS: {
+        uint8_t chunkCount;
+        size_t length = encodeSettings(frame + 3, _request[3], &chunkCount);
+        uint8_t chunkIndex = _request[3] < chunkCount ? _request[3] : chunkCount - 1;
+
+        frame[1] = chunkCount - chunkIndex - 1;
+        frame[2] = length;
+        respond(frame, length + 4, arrivalTime);
+        break;
+      }
+
+      case COMMAND_READ_SETTING_DETAIL: {
+        // Unknown settings get an empty detail
+        uint8_t detail[SIMULATED_CAMERA_CHUNK_SIZE * 2];
+        SimulatedSetting *setting = getSetting(_request[2]);
+        size_t length = setting != NULL ? encodeSettingDetail(detail, setting) : 0;
+
+        respondChunk(detail, length, _request[3], arrivalTime);
+        break;
+      }
+
+      case COMMAND_WRITE_SETTING: {
+        SimulatedSetting *setting = getSetting(_request[2]);
+        uint8_t resultCode = writeSetting(setting, _request + 3);
+
+        frame[1] = resultCode;
+        frame[2] = resultCode == 0 && setting->refreshOnWrite ? 1 : 0;
+        respond(frame, 4, arrivalTime);
+        break;
+      }
+
+      case COMMAND_DISPLAY_FILL_REGION: {
+        for (uint8_t y = 0; y < _request[5]; y++) {
+          for (uint8_t x = 0; x < _request[4]; x++) {
+            putChar(_request[2] + x, _request[3] + y, _request[6]);
+          }
+        }
+        _displayCommandCount++;
+        break;
+      }
+
+      case COMMAND_DISPLAY_WRITE_CHAR: {
+        putChar(_request[2], _request[3], _request[4]);
+        _displayCommandCount++;
+        break;
+      }
+
+      case COMMAND_DISPLAY_WRITE_HORIZONTAL_STRING:
+      case COMMAND_DISPLAY_WRITE_VERTICAL_STRING: {
+        bool horizontal = _request[1] == COMMAND_DISPLAY_WRITE_HORIZONTAL_STRING;
+        for (uint8_t i = 0; i < _request[2]; i++) {
+          putChar(_request[3] + (horizontal ? i : 0), _request[4] + (horizontal ? 0 : i), _request[i + 5]);
+        }
+        _displayCommandCount++;
+        break;
+      }
+
+      case COMMAND_DISPLAY_WRITE_STRING: {
+        for (uint8_t i = 0; i < _request[2] / 3; i++) {
+          putChar(_request[i * 3 + 3], _request[i * 3 + 4], _request[i * 3 + 5]);
+        }
+        _displayCommandCount++;
+        break;
+      }
+    }
+  }
+
+  // Queue a response to go out after the turnaround time, or once the previous one has been sent
+  void SimulatedCamera::respond(uint8_t *frame, uint8_t length, unsigned long arrivalTime) {
+    frame[0] = COMMAND_HEADER;
+    frame[length - 1] = Crc8::calc(frame, length - 1);
+
+    unsigned long time = arrivalTime + _turnaroundTime;
+    if ((long)(_rxFreeTime - time) > 0) {
+      time = _rxFreeTime;
+    }
+
+    queue(_noise, _noiseLength, &time);
+    _noiseLength = 0;
+
+    queue(frame, length, &time);
+    _rxFreeTime = time;
+  }
+
+  // Each byte arrives a byte time after the one before
+  void SimulatedCamera::queue(const uint8_t *data, uint8_t length, unsigned long *time) {
+    for (uint8_t i = 0; i < length && _rxCount < SIMULATED_CAMERA_RX_SIZE; i++) {
+      *time += _byteTime;
+
+      uint16_t tail = (_rxHead + _rxCount) % SIMULATED_CAMERA_RX_SIZE;
+      _rx[tail] = data[i];
+      _rxTime[tail] = *time;
+      _rxCount++;
+      _bytesSent++;
+    }
+  }
+
+  void SimulatedCamera::respondChunk(const uint8_t *data, size_t length, uint8_t chunkIndex, unsigned long arrivalTime) {
+    uint8_t frame[BUFF_SIZE];
+
+    uint8_t chunkCount = length == 0 ? 1 : (length + SIMULATED_CAMERA_CHUNK_SIZE - 1) / SIMULATED_CAMERA_CHUNK_SIZE;
+    if (chunkIndex >= chunkCount) {
+      chunkIndex = chunkCount - 1;
+    }
+
+    size_t start = chunkIndex * SIMULATED_CAMERA_CHUNK_SIZE;
+    size_t chunkLength = length - start < SIMULATED_CAMERA_CHUNK_SIZE ? length - start : SIMULATED_CAMERA_CHUNK_SIZE;
+
+    frame[1] = chunkCount - chunkIndex - 1;
+    frame[2] = chunkLength;
+    memcpy(frame + 3, data + start, chunkLength);
+
+    respond(frame, chunkLength + 4, arrivalTime);
+  }
+
+  // The setting list is split into chunks without breaking an entry across two
+  size_t SimulatedCamera::encodeSettings(uint8_t *buf, uint8_t chunkIndex, uint8_t *chunkCount) {
+    uint8_t entry[SIMULATED_CAMERA_CHUNK_SIZE];
+    uint8_t chunk = 0;
+    size_t used = 0;
+    size_t length = 0;
+
+    for (uint8_t i = 0; i < SIMULATED_CAMERA_SETTING_COUNT; i++) {
+      const SimulatedSetting *setting = &_settings[i];
+
+      // [id] [name] 0 [value] 0
+      size_t nameLength = strlen(setting->name);
+      entry[0] = setting->id;
+      memcpy(entry + 1, setting->name, nameLength + 1);
+      size_t entryLength = nameLength + 2 + encodeSettingValue(entry + nameLength + 2, setting);
+
+      if (used + entryLength > SIMULATED_CAMERA_CHUNK_SIZE) {
+        chunk++;
+        used = 0;
+      }
+
+      if (chunk == chunkIndex || (chunkIndex > chunk && i == SIMULATED_CAMERA_SETTING_COUNT - 1)) {
+        memcpy(buf + used, entry, entryLength);
+        length = used + entryLength;
+      }
+
+      used += entryLength;
+    }
+
+    *chunkCount = chunk + 1;
+
+    return length;
+  }
+
+  // The value as text, including the terminator.  Text selections show the selected option.
+  size_t SimulatedCamera::encodeSettingValue(uint8_t *buf, const SimulatedSetting *setting) {
+    size_t length = 0;
+
+    switch (setting->type) {
+      case SETTING_TYPE_TEXT_SELECTION: {
+        const char *option = setting->options;
+        for (uint8_t i = 0; i < setting->value && option != NULL; i++) {
+          option = strchr(option, ';');
+          if (option != NULL) {
+            option++;
+          }
+        }
+
+        while (option != NULL && option[length] != 0 && option[length] != ';') {
+          buf[length] = option[length];
+          length++;
+        }
+        break;
+      }
+
+      case SETTING_TYPE_UINT8: {
+        uint8_t value = setting->value;
+        if (value >= 100) {
+          buf[length++] = '0' + value / 100;
+        }
+        if (value >= 10) {
+          buf[length++] = '0' + (value / 10) % 10;
+        }
+        buf[length++] = '0' + value % 10;
+        break;
+      }
+
+      default: {
+        length = strlen(setting->text);
+        memcpy(buf, setting->text, length);
+        break;
+      }
+    }
+
+    buf[length] = 0;
+
+    return length + 1;
+  }
+
+  size_t SimulatedCamera::encodeSettingDetail(uint8_t *buf, const SimulatedSetting *setting) {
+    size_t p = 0;
+    buf[p++] = setting->type;
+
+    switch (setting->type) {
+      case SETTING_TYPE_UINT8: {
+        // [value] [min] [max] [step size]
+        buf[p++] = setting->value;
+        buf[p++] = setting->min;
+        buf[p++] = setting->max;
+        buf[p++] = 1;
+        break;
+      }
+
+      case SETTING_TYPE_TEXT_SELECTION: {
+        // [selected] [options] 0
+        size_t length = strlen(setting->options);
+        buf[p++] = setting->value;
+        memcpy(buf + p, setting->options, length + 1);
+        p += length + 1;
+        break;
+      }
+
+      default: {
+        // [text] 0 [max length]
+        size_t length = strlen(setting->text);
+        memcpy(buf + p, setting->text, length + 1);
+        p += length + 1;
+        buf[p++] = setting->maxLength;
+        break;
+      }
+    }
+
+    return p;
+  }
+
+  // Returns the result code for the response, 0 if the write succeeded
+  uint8_t SimulatedCamera::writeSetting(SimulatedSetting *setting, const uint8_t *data) {
+    if (setting == NULL || !setting->writable) {
+      return 1;
+    }
+
+    if (setting->type == SETTING_TYPE_STRING) {
+      // [length] [text]
+      uint8_t textLength = data[0];
+      if (textLength > setting->maxLength || textLength > SIMULATED_CAMERA_MAX_TEXT) {
+        return 1;
+      }
+
+      memcpy(setting->text, data + 1, textLength);
+      setting->text[textLength] = 0;
+      return 0;
+    }
+
+    if (data[0] < setting->min || data[0] > setting->max) {
+      return 1;
+    }
+
+    setting->value = data[0];
+
+    if (setting->id == SETTINGID_DISP_RESOLUTION) {
+      SimulatedSetting *remaining = getSetting(SETTINGID_DISP_REMAIN_RECORDING_TIME);
+      strcpy(remaining->text, REMAINING_RECORDING_TIMES[setting->value]);
+    }
+
+    return 0;
+  }
+
+  void SimulatedCamera::putChar(uint8_t x, uint8_t y, uint8_t character) {
+    if (x < SIMULATED_CAMERA_COLUMNS && y < SIMULATED_CAMERA_ROWS) {
+      _screen[y][x] = character;
+    }
+  }
+}
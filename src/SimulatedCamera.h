@@ -0,0 +1,155 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SIMULATED_CAMERA_H__
+#define __SIMULATED_CAMERA_H__
+
+#include <Arduino.h>
+#include "RunCam_Protocol.h"
+
+#define SIMULATED_CAMERA_VERSION 4
+#define SIMULATED_CAMERA_FEATURES 0x3f                // Buttons, mode, 5-key, settings access and DisplayPort
+
+#define SIMULATED_CAMERA_DEFAULT_BOOT_MS 800          // Power on until the camera answers requests
+#define SIMULATED_CAMERA_DEFAULT_TURNAROUND_US 500    // End of a request until the first byte of its response
+
+#define SIMULATED_CAMERA_COLUMNS 30
+#define SIMULATED_CAMERA_ROWS 16                      // PAL
+
+#define SIMULATED_CAMERA_SETTING_COUNT 7
+#define SIMULATED_CAMERA_MAX_TEXT 32
+#define SIMULATED_CAMERA_CHUNK_SIZE SETTINGS_CHUNK_MAX_DATA
+
+#ifndef SIMULATED_CAMERA_RX_SIZE
+#define SIMULATED_CAMERA_RX_SIZE 128                  // Response bytes on their way to the host
+#endif
+
+#ifndef SIMULATED_CAMERA_TX_FIFO_SIZE
+#define SIMULATED_CAMERA_TX_FIFO_SIZE 64              // Bytes the host UART buffers before write() blocks
+#endif
+
+namespace RunCam {
+
+  struct SimulatedSetting {
+    uint8_t id;
+    uint8_t type;
+    const char *name;
+    const char *options;                  // ';' separated, text selections only
+    uint8_t value;                        // Selected option or UINT8 value
+    uint8_t min;
+    uint8_t max;
+    uint8_t maxLength;                    // Strings only
+    bool writable;
+    bool refreshOnWrite;                  // Writing it changes other settings
+    char text[SIMULATED_CAMERA_MAX_TEXT + 1];
+  };
+
+  // A Split 4 that lives in memory instead of on the end of a UART.  Protocol talks to it through the same
+  // HardwareSerial interface, so anything written against a real camera runs unchanged with no camera
+  // attached, on the board or on a host.
+  //
+  // The wire is modelled at 10 bits per byte.  Requests reach the camera as the host UART would clock them
+  // out, write() blocks once more than a FIFO's worth is waiting, and each response byte only becomes
+  // available once it would have been received.  Bytes sent at a different baud rate than the camera's, or
+  // before it has finished booting, are lost.
+  class SimulatedCamera : public HardwareSerial {
+    public:
+      SimulatedCamera(unsigned long baudRate = DEFAULT_BAUD_RATE, unsigned long bootTime = SIMULATED_CAMERA_DEFAULT_BOOT_MS);
+
+      // Reset the camera to its defaults and start booting
+      void powerOn();
+      bool isBooted();
+
+      void setTurnaroundTime(unsigned long turnaroundTime);
+
+      // Line noise.  The bytes go out just ahead of the next response.
+      bool injectNoise(const uint8_t *data, uint8_t length);
+      unsigned long getByteTime();
+
+      // Camera state, for checking what the host did
+      bool isRecording();
+      bool isFiveKeyConnected();
+      uint8_t getScreenChar(uint8_t x, uint8_t y);
+      SimulatedSetting *getSetting(uint8_t settingId);
+
+      uint32_t getRequestCount();
+      uint32_t getDisplayCommandCount();
+      uint32_t getDroppedByteCount();       // Garbled, sent while booting, or not part of a valid request
+      uint32_t getBytesReceived();
+      uint32_t getBytesSent();
+
+      // HardwareSerial
+      void begin(unsigned long baudRate);
+      void begin(unsigned long baudRate, uint16_t config);
+      void end();
+      int available();
+      int peek();
+      int read();
+      void flush();
+      size_t write(uint8_t data);
+      using Print::write;
+      operator bool();
+
+    private:
+      unsigned long _baudRate;              // The camera's
+      unsigned long _uartBaudRate;          // The host's, 0 when ended
+      unsigned long _byteTime;
+      unsigned long _bootTime;
+      unsigned long _turnaroundTime;
+      unsigned long _powerOnTime;
+
+      unsigned long _txFreeTime;            // When the host UART finishes sending what it has been given
+      unsigned long _rxFreeTime;            // When the camera finishes sending its last response
+
+      uint8_t _request[BUFF_SIZE];
+      uint8_t _requestLength;
+
+      uint8_t _noise[BUFF_SIZE];
+      uint8_t _noiseLength;
+
+      uint8_t _rx[SIMULATED_CAMERA_RX_SIZE];
+      unsigned long _rxTime[SIMULATED_CAMERA_RX_SIZE];
+      uint16_t _rxHead;
+      uint16_t _rxCount;
+
+      SimulatedSetting _settings[SIMULATED_CAMERA_SETTING_COUNT];
+      uint8_t _screen[SIMULATED_CAMERA_ROWS][SIMULATED_CAMERA_COLUMNS];
+      bool _recording;
+      bool _fiveKeyConnected;
+
+      uint32_t _requestCount;
+      uint32_t _displayCommandCount;
+      uint32_t _droppedByteCount;
+      uint32_t _bytesReceived;
+      uint32_t _bytesSent;
+
+      void reset();
+      void receive(uint8_t data, unsigned long arrivalTime);
+      int getRequestLength();
+      void handleRequest(unsigned long arrivalTime);
+      void respond(uint8_t *frame, uint8_t length, unsigned long arrivalTime);
+      void queue(const uint8_t *data, uint8_t length, unsigned long *time);
+      void respondChunk(const uint8_t *data, size_t length, uint8_t chunkIndex, unsigned long arrivalTime);
+      size_t encodeSettings(uint8_t *buf, uint8_t chunkIndex, uint8_t *chunkCount);
+      size_t encodeSettingValue(uint8_t *buf, const SimulatedSetting *setting);
+      size_t encodeSettingDetail(uint8_t *buf, const SimulatedSetting *setting);
+      uint8_t writeSetting(SimulatedSetting *setting, const uint8_t *data);
+      void putChar(uint8_t x, uint8_t y, uint8_t character);
+  };
+
+}
+
+#endif // __SIMULATED_CAMERA_H__
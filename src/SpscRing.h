@@ -0,0 +1,93 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SPSC_RING_H__
+#define __SPSC_RING_H__
+
+#include <Arduino.h>
+
+// Lock-free rings need std::atomic, which AVR toolchains do not ship
+#if defined(__has_include)
+#if __has_include(<atomic>)
+#define RUNCAM_HAS_ATOMIC
+#endif
+#endif
+
+#ifdef RUNCAM_HAS_ATOMIC
+
+#include <atomic>
+
+namespace RunCam {
+
+  // Fixed size FIFO between exactly one producer thread and one consumer thread, with no locks.  Used the
+  // same way as CommandQueue: the producer fills the slot from reserve() then commit()s it, the consumer
+  // reads front() then pop()s it.  Each index is only written by one side, so publishing a slot is a
+  // release store that the other side's acquire load pairs with.
+  template <typename T, uint8_t SIZE>
+  class SpscRing {
+    public:
+      SpscRing() : _head(0), _tail(0) {
+      }
+
+      // Producer.  NULL if the ring is full.
+      T *reserve() {
+        uint8_t tail = _tail.load(std::memory_order_relaxed);
+        if ((uint8_t)(tail - _head.load(std::memory_order_acquire)) == SIZE) {
+          return NULL;
+        }
+
+        return &_slots[tail % SIZE];
+      }
+
+      void commit() {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+      }
+
+      // Consumer.  NULL if the ring is empty.
+      T *front() {
+        uint8_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+          return NULL;
+        }
+
+        return &_slots[head % SIZE];
+      }
+
+      void pop() {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+      }
+
+      // Either side, a snapshot that may already be out of date
+      uint8_t size() {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+      }
+
+    private:
+      // Free running so full and empty can be told apart, which is why SIZE must divide 256
+      static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0 && SIZE <= 128, "SpscRing SIZE must be a power of 2 up to 128");
+
+      T _slots[SIZE];
+
+      // On separate cache lines so the two threads don't contend for one
+      alignas(64) std::atomic<uint8_t> _head;
+      alignas(64) std::atomic<uint8_t> _tail;
+  };
+
+}
+
+#endif
+
+#endif // __SPSC_RING_H__
@@ -0,0 +1,260 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TermiosTransport.h"
+
+#ifdef RUNCAM_HAS_TERMIOS_TRANSPORT
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace RunCam {
+
+  struct TermiosSpeed {
+    unsigned long baudRate;
+    speed_t speed;
+  };
+
+  static const TermiosSpeed TERMIOS_SPEEDS[] = {
+    { 9600, B9600 },
+    { 19200, B19200 },
+    { 38400, B38400 },
+    { 57600, B57600 },
+    { 115200, B115200 },
+    { 230400, B230400 },
+    { 460800, B460800 },
+    { 921600, B921600 },
+  };
+
+  TermiosTransport::TermiosTransport(const char *path) {
+    _path = path;
+    _fd = -1;
+    _open = false;
+    _error = 0;
+    _openCount = 0;
+    _rxHead = 0;
+    _rxCount = 0;
+  }
+
+  TermiosTransport::TermiosTransport(int fd) {
+    _path = NULL;
+    _fd = fd;
+    _open = false;
+    _error = 0;
+    _openCount = 0;
+    _rxHead = 0;
+    _rxCount = 0;
+  }
+
+  int TermiosTransport::getFd() {
+    return _fd;
+  }
+
+  uint32_t TermiosTransport::getOpenCount() {
+    return _openCount;
+  }
+
+  int TermiosTransport::getError() {
+    return _error;
+  }
+
+  speed_t TermiosTransport::getSpeed(unsigned long baudRate) {
+    for (size_t i = 0; i < sizeof(TERMIOS_SPEEDS) / sizeof(TERMIOS_SPEEDS[0]); i++) {
+      if (TERMIOS_SPEEDS[i].baudRate == baudRate) {
+        return TERMIOS_SPEEDS[i].speed;
+      }
+    }
+
+    return 0;
+  }
+
+  void TermiosTransport::fail() {
+    _error = errno;
+  }
+
+  bool TermiosTransport::configure(unsigned long baudRate) {
+    speed_t speed = getSpeed(baudRate);
+    if (speed == 0) {
+      _error = EINVAL;
+      return false;
+    }
+
+    struct termios tio;
+    if (tcgetattr(_fd, &tio) != 0) {
+      fail();
+      return false;
+    }
+
+    // 8N1, no flow control, no line discipline.  Reads return whatever has arrived without waiting.
+    cfmakeraw(&tio);
+    tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+    tio.c_cflag |= CLOCAL | CREAD;
+    tio.c_cc[VMIN] = 0;
+    tio.c_cc[VTIME] = 0;
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+
+    if (tcsetattr(_fd, TCSANOW, &tio) != 0) {
+      fail();
+      return false;
+    }
+
+    int flags = fcntl(_fd, F_GETFL);
+    if (flags < 0 || fcntl(_fd, F_SETFL, flags | O_NONBLOCK) != 0) {
+      fail();
+      return false;
+    }
+
+    tcflush(_fd, TCIOFLUSH);
+    return true;
+  }
+
+  void TermiosTransport::begin(unsigned long baudRate) {
+    begin(baudRate, SERIAL_8N1);
+  }
+
+  void TermiosTransport::begin(unsigned long baudRate, uint16_t /* config */) {
+    // Protocol changes baud rate with end() and begin(), and only ever uses 8N1
+    end();
+
+    _error = 0;
+    _rxHead = 0;
+    _rxCount = 0;
+
+    if (_path != NULL) {
+      _fd = open(_path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+      if (_fd < 0) {
+        fail();
+        return;
+      }
+    } else if (_fd < 0) {
+      _error = EBADF;
+      return;
+    }
+
+    if (!configure(baudRate)) {
+      if (_path != NULL) {
+        close(_fd);
+        _fd = -1;
+      }
+      return;
+    }
+
+    _open = true;
+    _openCount++;
+  }
+
+  void TermiosTransport::end() {
+    if (!_open) {
+      return;
+    }
+
+    _open = false;
+    _rxCount = 0;
+    if (_path != NULL) {
+      close(_fd);
+      _fd = -1;
+    }
+  }
+
+  void TermiosTransport::fill() {
+    if (!_open || _rxCount == TERMIOS_TRANSPORT_RX_SIZE) {
+      return;
+    }
+
+    // Only into the contiguous free space, the rest comes on the next call
+    uint16_t tail = (_rxHead + _rxCount) % TERMIOS_TRANSPORT_RX_SIZE;
+    size_t space = tail >= _rxHead ? TERMIOS_TRANSPORT_RX_SIZE - tail : _rxHead - tail;
+    ssize_t count = ::read(_fd, &_rxBuf[tail], space);
+    if (count > 0) {
+      _rxCount += count;
+    } else if (count < 0 && errno != EAGAIN && errno != EINTR) {
+      fail();
+    }
+  }
+
+  int TermiosTransport::available() {
+    fill();
+    return _rxCount;
+  }
+
+  int TermiosTransport::peek() {
+    if (_rxCount == 0) {
+      fill();
+      if (_rxCount == 0) {
+        return -1;
+      }
+    }
+
+    return _rxBuf[_rxHead];
+  }
+
+  int TermiosTransport::read() {
+    int data = peek();
+    if (data >= 0) {
+      _rxHead = (_rxHead + 1) % TERMIOS_TRANSPORT_RX_SIZE;
+      _rxCount--;
+    }
+
+    return data;
+  }
+
+  void TermiosTransport::flush() {
+    if (_open) {
+      tcdrain(_fd);
+    }
+  }
+
+  size_t TermiosTransport::write(uint8_t data) {
+    return write(&data, 1);
+  }
+
+  size_t TermiosTransport::write(const uint8_t *buffer, size_t size) {
+    if (!_open) {
+      return 0;
+    }
+
+    // Blocks like a UART once the kernel's buffer is full, but gives up if the port stops draining
+    size_t written = 0;
+    while (written < size) {
+      ssize_t count = ::write(_fd, buffer + written, size - written);
+      if (count > 0) {
+        written += count;
+      } else if (count < 0 && errno == EAGAIN) {
+        struct pollfd output = { _fd, POLLOUT, 0 };
+        if (poll(&output, 1, TERMIOS_TRANSPORT_WRITE_TIMEOUT_MS) <= 0) {
+          _error = EAGAIN;
+          break;
+        }
+      } else if (count < 0 && errno != EINTR) {
+        fail();
+        break;
+      }
+    }
+
+    return written;
+  }
+
+  TermiosTransport::operator bool() {
+    return _open;
+  }
+
+}
+
+#endif
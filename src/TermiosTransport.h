@@ -0,0 +1,84 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TERMIOS_TRANSPORT_H__
+#define __TERMIOS_TRANSPORT_H__
+
+#if defined(__linux__) && !defined(ARDUINO)
+
+#define RUNCAM_HAS_TERMIOS_TRANSPORT
+
+#include <Arduino.h>
+#include <termios.h>
+
+#ifndef TERMIOS_TRANSPORT_RX_SIZE
+#define TERMIOS_TRANSPORT_RX_SIZE 256
+#endif
+
+#define TERMIOS_TRANSPORT_WRITE_TIMEOUT_MS 1000   // Longest write() waits for the port to take more bytes
+
+namespace RunCam {
+
+  // A serial port on Linux, such as /dev/ttyUSB0 or a pseudo-terminal, driven through termios.  The port
+  // is opened by begin() in raw, non-blocking mode so that available() and read() never wait, the same as
+  // a UART, and closed by end().  getFd() is for adding the port to poll() or epoll.
+  class TermiosTransport final : public HardwareSerial {
+    public:
+      TermiosTransport(const char *path);
+
+      // An already open descriptor, such as the slave end of openpty().  end() leaves it open.
+      TermiosTransport(int fd);
+
+      int getFd();
+      uint32_t getOpenCount();              // Successful begin() calls, the descriptor may change with each
+      int getError();                       // errno from the last failure, 0 if none
+
+      // The termios speed for a baud rate, or 0 if it has none
+      static speed_t getSpeed(unsigned long baudRate);
+
+      // HardwareSerial
+      void begin(unsigned long baudRate);
+      void begin(unsigned long baudRate, uint16_t config);
+      void end();
+      int available();
+      int peek();
+      int read();
+      void flush();
+      size_t write(uint8_t data);
+      size_t write(const uint8_t *buffer, size_t size);
+      using Print::write;
+      operator bool();
+
+    private:
+      const char *_path;
+      int _fd;
+      bool _open;
+      int _error;
+      uint32_t _openCount;
+      uint8_t _rxBuf[TERMIOS_TRANSPORT_RX_SIZE];
+      uint16_t _rxHead;
+      uint16_t _rxCount;
+
+      bool configure(unsigned long baudRate);
+      void fill();
+      void fail();
+  };
+
+}
+
+#endif
+
+#endif // __TERMIOS_TRANSPORT_H__
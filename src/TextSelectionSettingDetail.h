@@ -1,40 +0,0 @@
-/*
- * Copyright 2024-2025 Ben Voß
- *
- * Licensed under the Apache License, Version 2.0 (the "License");
- * you may not use this file except in compliance with the License.
- * You may obtain a copy of the License at
- *
- *     http://www.apache.org/licenses/LICENSE-2.0
- *
- * Unless required by applicable law or agreed to in writing, software
- * distributed under the License is distributed on an "AS IS" BASIS,
- * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
- * See the License for the specific language governing permissions and
- * limitations under the License.
- */
- 
-#ifndef __TEXT_SELECTION_SETTING_DETAIL_H__
-#define __TEXT_SELECTION_SETTING_DETAIL_H__
-
-#include <Arduino.h>
-#include <vector>
-#include "SettingDetail.h"
-
-namespace RunCam {
-
-  class TextSelectionSettingDetail : public SettingDetail {
-    public:
-      TextSelectionSettingDetail(uint8_t settingId, uint8_t settingType, uint16_t value, std::vector<String*>* textSelection);
-
-      uint16_t getValue();
-      std::vector<String*>* getTextSelection();
-
-    private:
-      uint16_t _value;
-      std::vector<String*>* _textSelection;
-  };
-
-}
-
-#endif // __TEXT_SELECTION_SETTING_DETAIL_H__
\ No newline at end of file
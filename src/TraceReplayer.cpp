@@ -0,0 +1,157 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "TraceReplayer.h"
+#include "CommandQueue.h"
+
+namespace RunCam {
+
+  TraceReplayer::TraceReplayer(unsigned long responseTimeout) {
+    _responseTimeout = responseTimeout;
+    _callback = NULL;
+    _context = NULL;
+  }
+
+  void TraceReplayer::setCallback(TraceResponseCallbackFuncPtr callback, void *context) {
+    _callback = callback;
+    _context = context;
+  }
+
+  const TraceReplayStats *TraceReplayer::getStats() {
+    return &_stats;
+  }
+
+  bool TraceReplayer::replay(const uint8_t *trace, size_t length) {
+    memset(&_stats, 0, sizeof(_stats));
+    _parser.reset();
+    _lastState = RESPONSE_PARSER_IDLE;
+
+    if (length < TRACE_HEADER_SIZE || trace[0] != 'R' || trace[1] != 'C' || trace[2] != 'T' || trace[3] != TRACE_FORMAT_VERSION) {
+      return false;
+    }
+
+    uint16_t count = trace[4] | trace[5] << 8;
+    unsigned long time = (unsigned long)trace[6] | (unsigned long)trace[7] << 8 | (unsigned long)trace[8] << 16 | (unsigned long)trace[9] << 24;
+    size_t p = TRACE_HEADER_SIZE;
+
+    for (uint16_t i = 0; i < count; i++) {
+      if (p + 3 > length) {
+        return false;
+      }
+
+      uint8_t type = trace[p++];
+      uint8_t data = trace[p++];
+
+      unsigned long delta = 0;
+      uint8_t shift = 0;
+      uint8_t b;
+      do {
+        if (p >= length || shift > 28) {
+          return false;
+        }
+
+        b = trace[p++];
+        delta |= (unsigned long)(b & 0x7f) << shift;
+        shift += 7;
+      } while (b & 0x80);
+
+      time += delta;
+      _stats.events++;
+
+      switch (type) {
+        case TRACE_EVENT_TX:
+          _stats.txBytes++;
+          break;
+
+        case TRACE_EVENT_RX:
+          _stats.rxBytes++;
+          checkTimeout(time);
+
+          if (_parser.getState() == RESPONSE_PARSER_PENDING && _parser.feed(data) != RESPONSE_PARSER_PENDING) {
+            finish(time);
+          }
+          break;
+
+        case TRACE_EVENT_EXPECT:
+          checkTimeout(time);
+          expect(data, time);
+          break;
+
+        case TRACE_EVENT_TIMEOUT:
+          if (_responseTimeout == TRACE_REPLAY_RECORDED_TIMEOUTS && _parser.getState() == RESPONSE_PARSER_PENDING) {
+            _parser.timeout();
+            finish(time);
+          }
+          break;
+
+        case TRACE_EVENT_RESULT:
+          // Only comparable when timing out where the recording did, and the trace didn't start part way
+          // through the response
+          if (_responseTimeout == TRACE_REPLAY_RECORDED_TIMEOUTS && _lastState != RESPONSE_PARSER_IDLE && data != _lastState) {
+            _stats.mismatches++;
+          }
+          _lastState = RESPONSE_PARSER_IDLE;
+          break;
+      }
+    }
+
+    return true;
+  }
+
+  void TraceReplayer::expect(uint8_t responseLength, unsigned long time) {
+    _expectTime = time;
+    _lastState = RESPONSE_PARSER_PENDING;
+
+    if (responseLength == RESPONSE_LENGTH_CHUNKED) {
+      _parser.expectChunked();
+    } else {
+      _parser.expect(responseLength);
+    }
+
+    // A bad length fails straight away
+    if (_parser.getState() != RESPONSE_PARSER_PENDING) {
+      finish(time);
+    }
+  }
+
+  void TraceReplayer::checkTimeout(unsigned long time) {
+    if (_responseTimeout != TRACE_REPLAY_RECORDED_TIMEOUTS && _parser.getState() == RESPONSE_PARSER_PENDING && time - _expectTime >= _responseTimeout) {
+      _parser.timeout();
+      finish(_expectTime + _responseTimeout);
+    }
+  }
+
+  void TraceReplayer::finish(unsigned long time) {
+    uint8_t state = _parser.getState();
+
+    _lastState = state;
+    _stats.responses++;
+
+    if (state == RESPONSE_PARSER_COMPLETE) {
+      _stats.complete++;
+    } else if (state == RESPONSE_PARSER_TIMEOUT) {
+      _stats.timeouts++;
+    } else {
+      _stats.errors++;
+    }
+
+    if (_callback != NULL) {
+      _callback(state, _parser.getFrame(), _parser.getLength(), time, _context);
+    }
+
+    _parser.reset();
+  }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __TRACE_REPLAYER_H__
+#define __TRACE_REPLAYER_H__
+
+#include <Arduino.h>
+#include "ProtocolTrace.h"
+#include "ResponseParser.h"
+
+#define TRACE_REPLAY_RECORDED_TIMEOUTS 0      // Time out where the trace did rather than after a fixed time
+
+namespace RunCam {
+
+  struct TraceReplayStats {
+    uint16_t events;
+    uint32_t txBytes;
+    uint32_t rxBytes;
+    uint16_t responses;
+    uint16_t complete;
+    uint16_t errors;
+    uint16_t timeouts;
+    uint16_t mismatches;                      // Responses that finished differently than when recorded
+  };
+
+  // Called as each replayed response finishes.  The frame is only valid during the call.
+  typedef void (*TraceResponseCallbackFuncPtr)(uint8_t state, const uint8_t *frame, uint8_t length, unsigned long time, void *context);
+
+  // Feeds a trace written by ProtocolTrace back through a ResponseParser.  Runs without a camera or a clock
+  // so failures in a capture can be reproduced exactly, and parser changes measured against real traffic.
+  //
+  // With a response timeout, responses time out when the trace timestamps say that long has passed
+  // instead of where the recording did, to see how a different timeout would have behaved.
+  class TraceReplayer {
+    public:
+      TraceReplayer(unsigned long responseTimeout = TRACE_REPLAY_RECORDED_TIMEOUTS);
+
+      void setCallback(TraceResponseCallbackFuncPtr callback, void *context);
+
+      // Returns false if the trace is truncated or not in a known format
+      bool replay(const uint8_t *trace, size_t length);
+      const TraceReplayStats *getStats();
+
+    private:
+      ResponseParser _parser;
+      unsigned long _responseTimeout;         // us, 0 to use the recorded timeouts
+      TraceResponseCallbackFuncPtr _callback;
+      void *_context;
+      TraceReplayStats _stats;
+      unsigned long _expectTime;
+      uint8_t _lastState;
+
+      void expect(uint8_t responseLength, unsigned long time);
+      void checkTimeout(unsigned long time);
+      void finish(unsigned long time);
+  };
+
+}
+
+#endif // __TRACE_REPLAYER_H__
@@ -0,0 +1,429 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ARDUINO
+
+#include "Arduino.h"
+#include "../TermiosTransport.h"
+
+#include <time.h>
+#include <sched.h>
+#include <poll.h>
+#include <unistd.h>
+
+ConsoleSerial Serial;
+
+static const char *getSerialPort() {
+  const char *path = getenv("RUNCAM_SERIAL_PORT");
+  return path != NULL ? path : "/dev/ttyUSB0";
+}
+
+RunCam::TermiosTransport Serial1(getSerialPort());
+
+static std::string formatInteger(unsigned long value, unsigned char base, bool negative) {
+  if (base < 2 || base > 36) {
+    base = DEC;
+  }
+  char digits[sizeof(unsigned long) * 8 + 2];
+  int i = sizeof(digits);
+  digits[--i] = '\0';
+  do {
+    uint8_t digit = value % base;
+    digits[--i] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value > 0);
+  if (negative) {
+    digits[--i] = '-';
+  }
+  return std::string(&digits[i]);
+}
+
+static std::string formatSigned(long value, unsigned char base) {
+  // Like Arduino, only decimal is signed
+  if (base == DEC && value < 0) {
+    return formatInteger(-(unsigned long)value, base, true);
+  }
+  return formatInteger((unsigned long)value, base, false);
+}
+
+static std::string formatDouble(double value, unsigned char decimalPlaces) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.*f", decimalPlaces, value);
+  return std::string(buffer);
+}
+
+String::String() {
+}
+
+String::String(const char *string) : _string(string ? string : "") {
+}
+
+String::String(const char *string, size_t length) : _string(string, length) {
+}
+
+String::String(const uint8_t *string, size_t length) : _string((const char *)string, length) {
+}
+
+String::String(char c) : _string(1, c) {
+}
+
+String::String(int value, unsigned char base) : _string(formatSigned(value, base)) {
+}
+
+String::String(unsigned int value, unsigned char base) : _string(formatInteger(value, base, false)) {
+}
+
+String::String(long value, unsigned char base) : _string(formatSigned(value, base)) {
+}
+
+String::String(unsigned long value, unsigned char base) : _string(formatInteger(value, base, false)) {
+}
+
+String::String(double value, unsigned char decimalPlaces) : _string(formatDouble(value, decimalPlaces)) {
+}
+
+unsigned int String::length() const {
+  return _string.length();
+}
+
+const char *String::c_str() const {
+  return _string.c_str();
+}
+
+char String::charAt(unsigned int index) const {
+  return index < _string.length() ? _string[index] : '\0';
+}
+
+char String::operator[](unsigned int index) const {
+  return charAt(index);
+}
+
+long String::toInt() const {
+  return atol(_string.c_str());
+}
+
+double String::toFloat() const {
+  return atof(_string.c_str());
+}
+
+bool String::equals(const String &other) const {
+  return _string == other._string;
+}
+
+bool String::operator==(const String &other) const {
+  return equals(other);
+}
+
+bool String::operator==(const char *other) const {
+  return _string == (other ? other : "");
+}
+
+bool String::operator!=(const String &other) const {
+  return !equals(other);
+}
+
+bool String::operator!=(const char *other) const {
+  return !(*this == other);
+}
+
+bool String::startsWith(const String &prefix) const {
+  return _string.compare(0, prefix._string.length(), prefix._string) == 0;
+}
+
+bool String::endsWith(const String &suffix) const {
+  return _string.length() >= suffix._string.length() &&
+    _string.compare(_string.length() - suffix._string.length(), suffix._string.length(), suffix._string) == 0;
+}
+
+int String::indexOf(char c, unsigned int from) const {
+  size_t index = _string.find(c, from);
+  return index == std::string::npos ? -1 : (int)index;
+}
+
+int String::indexOf(const String &string, unsigned int from) const {
+  size_t index = _string.find(string._string, from);
+  return index == std::string::npos ? -1 : (int)index;
+}
+
+String String::substring(unsigned int begin) const {
+  return substring(begin, _string.length());
+}
+
+String String::substring(unsigned int begin, unsigned int end) const {
+  if (begin > end) {
+    unsigned int swap = begin;
+    begin = end;
+    end = swap;
+  }
+  if (begin >= _string.length()) {
+    return String();
+  }
+  if (end > _string.length()) {
+    end = _string.length();
+  }
+  return String(_string.c_str() + begin, end - begin);
+}
+
+void String::trim() {
+  size_t begin = _string.find_first_not_of(" \t\r\n\f\v");
+  if (begin == std::string::npos) {
+    _string.clear();
+    return;
+  }
+  size_t end = _string.find_last_not_of(" \t\r\n\f\v");
+  _string = _string.substr(begin, end - begin + 1);
+}
+
+bool String::concat(const String &string) {
+  _string += string._string;
+  return true;
+}
+
+String &String::operator+=(const String &string) {
+  concat(string);
+  return *this;
+}
+
+String operator+(const String &a, const String &b) {
+  String result(a);
+  result += b;
+  return result;
+}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t count = 0;
+  while (count < size && write(buffer[count])) {
+    count++;
+  }
+  return count;
+}
+
+size_t Print::write(const char *string) {
+  return string ? write((const uint8_t *)string, strlen(string)) : 0;
+}
+
+size_t Print::print(const String &string) {
+  return write((const uint8_t *)string.c_str(), string.length());
+}
+
+size_t Print::print(const char *string) {
+  return write(string);
+}
+
+size_t Print::print(char c) {
+  return write((uint8_t)c);
+}
+
+size_t Print::print(int value, int base) {
+  return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+  return print(String(value, base));
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return print(String(value, base));
+}
+
+size_t Print::print(double value, int digits) {
+  return print(String(value, digits));
+}
+
+size_t Print::println() {
+  return write((const uint8_t *)"\r\n", 2);
+}
+
+size_t Print::println(const String &string) {
+  return print(string) + println();
+}
+
+size_t Print::println(const char *string) {
+  return print(string) + println();
+}
+
+size_t Print::println(char c) {
+  return print(c) + println();
+}
+
+size_t Print::println(int value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(double value, int digits) {
+  return print(value, digits) + println();
+}
+
+void Stream::setTimeout(unsigned long timeout) {
+  _timeout = timeout;
+}
+
+int Stream::timedRead() {
+  unsigned long start = millis();
+  do {
+    int data = read();
+    if (data >= 0) {
+      return data;
+    }
+    yield();
+  } while (millis() - start < _timeout);
+  return -1;
+}
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length) {
+  size_t count = 0;
+  while (count < length) {
+    int data = timedRead();
+    if (data < 0) {
+      break;
+    }
+    buffer[count++] = data;
+  }
+  return count;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length) {
+  return readBytes((uint8_t *)buffer, length);
+}
+
+String Stream::readStringUntil(char terminator) {
+  std::string string;
+  int data = timedRead();
+  while (data >= 0 && data != terminator) {
+    string += (char)data;
+    data = timedRead();
+  }
+  return String(string.c_str(), string.length());
+}
+
+void ConsoleSerial::begin(unsigned long baudRate) {
+  begin(baudRate, SERIAL_8N1);
+}
+
+void ConsoleSerial::begin(unsigned long /* baudRate */, uint16_t /* config */) {
+  // Sketches print progress a line at a time
+  setvbuf(stdout, NULL, _IOLBF, 0);
+}
+
+void ConsoleSerial::end() {
+  flush();
+}
+
+int ConsoleSerial::available() {
+  if (_peek >= 0) {
+    return 1;
+  }
+  struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+  return poll(&input, 1, 0) > 0 && (input.revents & POLLIN) ? 1 : 0;
+}
+
+int ConsoleSerial::peek() {
+  if (_peek < 0 && available()) {
+    uint8_t data;
+    if (::read(STDIN_FILENO, &data, 1) == 1) {
+      _peek = data;
+    }
+  }
+  return _peek;
+}
+
+int ConsoleSerial::read() {
+  int data = peek();
+  _peek = -1;
+  return data;
+}
+
+void ConsoleSerial::flush() {
+  fflush(stdout);
+}
+
+size_t ConsoleSerial::write(uint8_t data) {
+  return fputc(data, stdout) == EOF ? 0 : 1;
+}
+
+size_t ConsoleSerial::write(const uint8_t *buffer, size_t size) {
+  return fwrite(buffer, 1, size, stdout);
+}
+
+ConsoleSerial::operator bool() {
+  return true;
+}
+
+static struct timespec getMonotonicTime() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now;
+}
+
+// Arduino's clocks start at boot; these start with the program
+static const struct timespec START_TIME = getMonotonicTime();
+
+unsigned long millis() {
+  struct timespec now = getMonotonicTime();
+  return (unsigned long)(now.tv_sec - START_TIME.tv_sec) * 1000UL + (now.tv_nsec - START_TIME.tv_nsec) / 1000000L;
+}
+
+unsigned long micros() {
+  struct timespec now = getMonotonicTime();
+  return (unsigned long)(now.tv_sec - START_TIME.tv_sec) * 1000000UL + (now.tv_nsec - START_TIME.tv_nsec) / 1000L;
+}
+
+void delay(unsigned long ms) {
+  struct timespec duration = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000L };
+  while (nanosleep(&duration, &duration) != 0) {
+  }
+}
+
+void delayMicroseconds(unsigned int us) {
+  // Sleeping overshoots by more than the short gaps this is used for, so spin
+  unsigned long start = micros();
+  while (micros() - start < us) {
+  }
+}
+
+void yield() {
+  sched_yield();
+}
+
+long random(long max) {
+  return max > 0 ? ::random() % max : 0;
+}
+
+long random(long min, long max) {
+  return min < max ? min + random(max - min) : min;
+}
+
+void randomSeed(unsigned long seed) {
+  srandom(seed);
+}
+
+#endif // ARDUINO
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2024-2025 Ben Voß
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// The parts of the Arduino API the library uses, for building it on Linux.  Add this directory to the
+// include path ahead of anything else and compile host/Arduino.cpp with the library sources.  Arduino
+// builds never see it.
+
+#ifndef __RUNCAM_HOST_ARDUINO_H__
+#define __RUNCAM_HOST_ARDUINO_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <string>
+
+#define SERIAL_8N1 0x06
+
+#define DEC 10
+#define HEX 16
+
+#define F(string) (string)
+
+class String {
+  public:
+    String();
+    String(const char *string);
+    String(const char *string, size_t length);
+    String(const uint8_t *string, size_t length);
+    String(char c);
+    String(int value, unsigned char base = DEC);
+    String(unsigned int value, unsigned char base = DEC);
+    String(long value, unsigned char base = DEC);
+    String(unsigned long value, unsigned char base = DEC);
+    String(double value, unsigned char decimalPlaces = 2);
+
+    unsigned int length() const;
+    const char *c_str() const;
+    char charAt(unsigned int index) const;
+    char operator[](unsigned int index) const;
+
+    long toInt() const;
+    double toFloat() const;
+
+    bool equals(const String &other) const;
+    bool operator==(const String &other) const;
+    bool operator==(const char *other) const;
+    bool operator!=(const String &other) const;
+    bool operator!=(const char *other) const;
+
+    bool startsWith(const String &prefix) const;
+    bool endsWith(const String &suffix) const;
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String &string, unsigned int from = 0) const;
+    String substring(unsigned int begin) const;
+    String substring(unsigned int begin, unsigned int end) const;
+    void trim();
+
+    bool concat(const String &string);
+    String &operator+=(const String &string);
+    friend String operator+(const String &a, const String &b);
+
+  private:
+    std::string _string;
+};
+
+class Print {
+  public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t data) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *string);
+
+    size_t print(const String &string);
+    size_t print(const char *string);
+    size_t print(char c);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println();
+    size_t println(const String &string);
+    size_t println(const char *string);
+    size_t println(char c);
+    size_t println(int value, int base = DEC);
+    size_t println(unsigned int value, int base = DEC);
+    size_t println(long value, int base = DEC);
+    size_t println(unsigned long value, int base = DEC);
+    size_t println(double value, int digits = 2);
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout);
+    size_t readBytes(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length);
+    String readStringUntil(char terminator);
+
+  protected:
+    unsigned long _timeout = 1000;
+
+    int timedRead();
+};
+
+class HardwareSerial : public Stream {
+  public:
+    virtual void begin(unsigned long baudRate) = 0;
+    virtual void begin(unsigned long baudRate, uint16_t config) = 0;
+    virtual void end() = 0;
+    virtual void flush() = 0;
+    virtual operator bool() = 0;
+    using Print::write;
+};
+
+// stdin and stdout
+class ConsoleSerial : public HardwareSerial {
+  public:
+    void begin(unsigned long baudRate);
+    void begin(unsigned long baudRate, uint16_t config);
+    void end();
+    int available();
+    int peek();
+    int read();
+    void flush();
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *buffer, size_t size);
+    using Print::write;
+    operator bool();
+
+  private:
+    int _peek = -1;
+};
+
+extern ConsoleSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+// Serial1 is the camera's port, /dev/ttyUSB0 unless RUNCAM_SERIAL_PORT names another.  The library's
+// headers complete the type.
+namespace RunCam {
+  class TermiosTransport;
+}
+
+extern RunCam::TermiosTransport Serial1;
+
+#endif // __RUNCAM_HOST_ARDUINO_H__
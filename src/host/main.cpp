@@ -13,17 +13,20 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
- 
-#include "InfoSettingDetail.h"
 
-namespace RunCam {
+#ifndef ARDUINO
 
-  InfoSettingDetail::InfoSettingDetail(uint8_t settingId, uint8_t settingType, String value) : SettingDetail(settingId, settingType) {
-    _value = value;
-  }
+#include "Arduino.h"
+
+// The sketch
+void setup();
+void loop();
 
-  String InfoSettingDetail::getValue() {
-    return _value;
+int main() {
+  setup();
+  for (;;) {
+    loop();
   }
+}
 
-}
\ No newline at end of file
+#endif // ARDUINO